@@ -0,0 +1,84 @@
+/*
+    Copyright 2021 Luke A.C.A. Rieff
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/*
+    HTTP Buffer Pool: Caches buffers of a few size classes, so connections can
+     take a buffer only while they need one, and grow it when it's too small.
+     A pool belongs to a single thread, so there is no locking.
+*/
+
+#ifndef _HTTP_BUFFER_POOL_H
+#define _HTTP_BUFFER_POOL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/// The number of size classes, and the size of the smallest one, every next
+///  class is four times as large (2, 8 and 32 KiB).
+#define HTTP_BUFFER_POOL_CLASS_COUNT 3
+#define HTTP_BUFFER_POOL_MIN_SIZE 2048
+#define HTTP_BUFFER_POOL_MAX_SIZE                                              \
+  (HTTP_BUFFER_POOL_MIN_SIZE << (2 * (HTTP_BUFFER_POOL_CLASS_COUNT - 1)))
+
+/// The maximum number of free buffers kept per size class, the rest is given
+///  back to the allocator.
+#define HTTP_BUFFER_POOL_MAX_CACHED 256
+
+///////////////////////////////////////////////////////////////////////////////
+// Data Types
+///////////////////////////////////////////////////////////////////////////////
+
+/// A free buffer, the link is stored inside the buffer memory itself.
+struct http_buffer_pool__free {
+  struct http_buffer_pool__free *next;
+};
+typedef struct http_buffer_pool__free http_buffer_pool__free_t;
+
+typedef struct {
+  http_buffer_pool__free_t *free[HTTP_BUFFER_POOL_CLASS_COUNT];
+  size_t free_count[HTTP_BUFFER_POOL_CLASS_COUNT];
+} http_buffer_pool_t;
+
+///////////////////////////////////////////////////////////////////////////////
+// HTTP Buffer Pool
+///////////////////////////////////////////////////////////////////////////////
+
+/// Gets the index of the smallest class which holds the specified size, or
+///  -1 if it's larger than the largest class.
+int32_t __http_buffer_pool_class(size_t size);
+
+/// Initializes a buffer pool.
+void http_buffer_pool_init(http_buffer_pool_t *pool);
+
+/// Frees all the cached buffers of a buffer pool.
+void http_buffer_pool_free(http_buffer_pool_t *pool);
+
+/// Gets the size of the smallest class which holds the specified size, or
+///  zero if it's larger than the largest class.
+size_t http_buffer_pool_class_size(size_t size);
+
+/// Gets a buffer of at least the specified size, its actual size is stored
+///  in size_out. Returns NULL if the size is too large, or allocation fails.
+uint8_t *http_buffer_pool_get(http_buffer_pool_t *pool, size_t size,
+                              size_t *size_out);
+
+/// Gives a buffer of the specified (class) size back to the pool.
+void http_buffer_pool_put(http_buffer_pool_t *pool, uint8_t *buffer,
+                          size_t size);
+
+#endif
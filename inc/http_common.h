@@ -19,18 +19,40 @@
 
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <ctype.h>
 #include <errno.h>
 #include <string.h>
 
+/// A part of a buffer as offset and length, unlike a pointer it stays valid
+///  when the buffer is moved.
+typedef struct {
+    uint32_t offset;
+    uint32_t len;
+} http_slice_t;
+
+/// Gets the first byte of a slice inside the specified buffer.
+#define http_slice_ptr(BUFFER, SLICE) ((const char *) &(BUFFER)[(SLICE).offset])
+
 /// Prints an error code with custom message.
 void errc_print (const char *message);
 
 /// Compares two strings case insensitive.
 bool strcicmp (const char *a, const char *b);
 
+/// Compares the first len bytes of a, which does not have to be terminated,
+///  with the string b case insensitive.
+bool strncicmp (const char *a, size_t len, const char *b);
+
 /// Gets the extension from an file.
 const char *path_get_ext (const char *path);
 
+/// Writes the decimal representation of value to buffer (which must hold at
+///  least 21 bytes), and returns the number of digits.
+size_t u64_to_string (char *buffer, uint64_t value);
+
+/// Hashes an string (FNV-1a), used as key by the caches.
+uint64_t string_hash (const char *str);
+
 #endif
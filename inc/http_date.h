@@ -0,0 +1,53 @@
+/*
+    Copyright 2021 Luke A.C.A. Rieff
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/*
+    HTTP Date: The value of the Date header, formatted once per second and
+     shared by all pools. The pools refresh it from their event loop, and
+     publish it by swapping a pointer, so the responses only copy it.
+*/
+
+#ifndef _HTTP_DATE_H
+#define _HTTP_DATE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+/// The length of an IMF-fixdate, for example "Sun, 06 Nov 1994 08:49:37 GMT".
+#define HTTP_DATE_SIZE 29
+
+/// The number of buffers the date rotates through, a reader which got the
+///  previous one has this many seconds to copy it before it's overwritten.
+#define HTTP_DATE_SLOTS 8
+
+///////////////////////////////////////////////////////////////////////////////
+// HTTP Date
+///////////////////////////////////////////////////////////////////////////////
+
+/// Formats the specified time as IMF-fixdate into buffer, which must hold
+///  HTTP_DATE_SIZE bytes plus the terminating zero.
+void http_date_format(char *buffer, time_t t);
+
+/// Formats the date again if the second changed since the last time, only
+///  one of the pools calling this at the same time does the work.
+void http_date_update(void);
+
+/// Gets the current date, HTTP_DATE_SIZE bytes long.
+const char *http_date_get(void);
+
+#endif
@@ -0,0 +1,158 @@
+/*
+    Copyright 2021 Luke A.C.A. Rieff
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/*
+    HTTP File Cache: Keeps the static files open, together with their size,
+     content type and the pre-rendered headers which describe them. The cache
+     is shared by all pools, and split into shards which each have their own
+     lock. Entries are reference counted, so a file which is still being sent
+     stays open after it has been evicted.
+*/
+
+#ifndef _HTTP_FILE_CACHE_H
+#define _HTTP_FILE_CACHE_H
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/stat.h>
+
+#include "http_accept_range.h"
+#include "http_common.h"
+#include "http_content_type.h"
+#include "http_timer_wheel.h"
+
+/// The number (power of two) of shards, and the number (power of two) of hash
+///  buckets in every shard.
+#define HTTP_FILE_CACHE_SHARDS 16
+#define HTTP_FILE_CACHE_BUCKETS 64
+
+/// The maximum number of files a shard keeps open, once full the least
+///  recently used one is evicted.
+#define HTTP_FILE_CACHE_SHARD_SIZE 16
+
+/// The number of milliseconds an entry is trusted, after that the next hit
+///  checks if the file on disk is still the same.
+#define HTTP_FILE_CACHE_TTL 2000
+
+///////////////////////////////////////////////////////////////////////////////
+// Data Types
+///////////////////////////////////////////////////////////////////////////////
+
+struct http_file_cache_entry {
+  struct http_file_cache_entry *next;
+  struct http_file_cache_entry *lru_next;
+  struct http_file_cache_entry *lru_prev;
+  //---------------------------//
+  uint64_t hash;
+  char *path;
+  uint32_t refs;
+  bool cached;
+  int64_t expires;
+  //---------------------------//
+  int32_t fd;
+  dev_t dev;
+  ino_t ino;
+  off_t size;
+  struct timespec mtime;
+  http_content_type_t type;
+  //---------------------------//
+  char *headers;
+  size_t headers_len;
+};
+typedef struct http_file_cache_entry http_file_cache_entry_t;
+
+/// A shard of the cache, these live on their own cache line so the pools do
+///  not bounce the locks of other shards between them.
+typedef struct {
+  pthread_mutex_t mutex;
+  http_file_cache_entry_t *buckets[HTTP_FILE_CACHE_BUCKETS];
+  http_file_cache_entry_t *lru_start, *lru_end;
+  size_t count;
+} __attribute__((aligned(64))) http_file_cache_shard_t;
+
+typedef struct {
+  http_file_cache_shard_t shards[HTTP_FILE_CACHE_SHARDS];
+} http_file_cache_t;
+
+///////////////////////////////////////////////////////////////////////////////
+// HTTP File Cache Entry
+///////////////////////////////////////////////////////////////////////////////
+
+/// Opens the file at the specified path and creates an entry for it, with
+///  a single reference. Returns NULL if it's not a regular file.
+http_file_cache_entry_t *__http_file_cache_entry_open(const char *path,
+                                                      uint64_t hash);
+
+/// Renders the headers which describe the file of the entry, in the same
+///  format they're written to the socket.
+int32_t __http_file_cache_entry_render(http_file_cache_entry_t *entry);
+
+/// Checks if the entry still describes the file with the specified stat.
+bool __http_file_cache_entry_matches(http_file_cache_entry_t *entry,
+                                     const struct stat *st);
+
+/// Takes an extra reference to an entry.
+void http_file_cache_entry_retain(http_file_cache_entry_t *entry);
+
+/// Drops a reference to an entry, the last one closes the file.
+void http_file_cache_entry_release(http_file_cache_entry_t *entry);
+
+///////////////////////////////////////////////////////////////////////////////
+// HTTP File Cache
+///////////////////////////////////////////////////////////////////////////////
+
+/// Finds the entry of the specified path inside a locked shard.
+http_file_cache_entry_t *__http_file_cache_find(http_file_cache_shard_t *shard,
+                                                uint64_t hash,
+                                                const char *path);
+
+/// Moves an entry to the front of the usage list of its locked shard.
+void __http_file_cache_touch(http_file_cache_shard_t *shard,
+                             http_file_cache_entry_t *entry);
+
+/// Removes an entry from its locked shard, the reference of the cache is
+///  handed to the caller, which should release it after unlocking.
+void __http_file_cache_unlink(http_file_cache_shard_t *shard,
+                              http_file_cache_entry_t *entry);
+
+/// Inserts an entry into its locked shard, if the shard is full the least
+///  recently used entry is unlinked and returned, otherwise NULL.
+http_file_cache_entry_t *
+__http_file_cache_insert(http_file_cache_shard_t *shard,
+                         http_file_cache_entry_t *entry);
+
+/// Initializes a file cache.
+int32_t http_file_cache_init(http_file_cache_t *cache);
+
+/// Frees a file cache, the entries which are still referenced stay open
+///  until they're released.
+void http_file_cache_free(http_file_cache_t *cache);
+
+/// Gets the entry of the file at the specified path, opening it if it's not
+///  cached or has changed. The caller must release the returned entry,
+///  returns NULL if the file can not be served.
+http_file_cache_entry_t *http_file_cache_get(http_file_cache_t *cache,
+                                             const char *path);
+
+#endif
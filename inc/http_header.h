@@ -39,6 +39,10 @@
 
 #define HTTP_PARSE_HEADER_FLAG_KEEP_INTACT      (1 << 0)
 
+/// The number of headers kept on the unused list for reuse, the headers
+///  above it are freed.
+#define HTTP_HEADERS_MAX_UNUSED                 32
+
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
@@ -56,6 +60,9 @@ struct http_header {
     const char         *key;
     const char         *value;
     struct http_header *next;
+    //---//
+    char               *storage;
+    size_t              storage_size;
 };
 
 typedef struct http_header http_header_t;
@@ -64,6 +71,8 @@ typedef struct {
     http_header_t  *start;
     http_header_t  *end;
     uint32_t        count;
+    http_header_t  *unused;
+    uint32_t        n_unused;
 } http_headers_t;
 
 typedef struct {
@@ -81,8 +90,15 @@ typedef void (*http_header_to_string_no_collapse_cb) (const char *, void *);
 /// Creates new HTTP headers structure.
 http_headers_t *http_headers_new (void);
 
-/// Copies an HTTP header, and stores the pointer in p. 
-int32_t __http_headers_insert_copy_val (const char **p);
+/// Takes an header from the unused list, or allocates a new one.
+http_header_t *__http_headers_take_header (http_headers_t *headers);
+
+/// Puts an header on the unused list, its storage is kept for the next one,
+///  once the list holds HTTP_HEADERS_MAX_UNUSED headers it is freed instead.
+void __http_headers_put_header (http_headers_t *headers, http_header_t *header);
+
+/// Makes sure the storage of an header can hold at least size bytes.
+int32_t __http_header_reserve_storage (http_header_t *header, size_t size);
 
 /// Adds the first item to the doubly-linked-list.
 void __http_header_insert_first (http_headers_t *headers, http_header_t *header);
@@ -115,6 +131,10 @@ void __http_header_free (http_header_t **header);
 /// Frees existing headers structure.
 int32_t http_headers_free (http_headers_t **headers);
 
+/// Removes all the headers inside the structure, but keeps the structure
+///  and the headers themselves for reuse.
+void http_headers_clear (http_headers_t *headers);
+
 /// Adds all headers from structure to another one.
 int32_t http_headers_add_all (http_headers_t *target, http_headers_t *from);
 
@@ -0,0 +1,78 @@
+/*
+    Copyright 2021 Luke A.C.A. Rieff
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/*
+    HTTP MPSC Queue: Bounded lock-free multiple-producer single-consumer queue,
+     every cell carries a sequence number which tells the producers and the
+     consumer whose turn it is. The items are copied into the cells, so
+     handing something over does not require an allocation.
+*/
+
+#ifndef _HTTP_MPSC_QUEUE_H
+#define _HTTP_MPSC_QUEUE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HTTP_MPSC_QUEUE_CACHE_LINE 64
+
+///////////////////////////////////////////////////////////////////////////////
+// Data Types
+///////////////////////////////////////////////////////////////////////////////
+
+/// The header of a cell, the item is stored right after it.
+typedef struct {
+  size_t sequence;
+} http_mpsc_queue__cell_t;
+
+typedef struct {
+  uint8_t *cells;
+  size_t mask;
+  size_t item_size;
+  size_t cell_size;
+  //---------------------------//
+  size_t enqueue_pos __attribute__((aligned(HTTP_MPSC_QUEUE_CACHE_LINE)));
+  size_t dequeue_pos __attribute__((aligned(HTTP_MPSC_QUEUE_CACHE_LINE)));
+} http_mpsc_queue_t;
+
+///////////////////////////////////////////////////////////////////////////////
+// HTTP MPSC Queue
+///////////////////////////////////////////////////////////////////////////////
+
+/// Initializes an MPSC queue of items of the specified size, the number of
+///  cells must be a power of two.
+int32_t http_mpsc_queue_init(http_mpsc_queue_t *queue, size_t size,
+                             size_t item_size);
+
+/// Frees the cells of an MPSC queue.
+void http_mpsc_queue_free(http_mpsc_queue_t *queue);
+
+/// Gets the cell at the specified position.
+http_mpsc_queue__cell_t *__http_mpsc_queue_cell(http_mpsc_queue_t *queue,
+                                                size_t pos);
+
+/// Copies an item into the queue, returns false if the queue is full. May be
+///  called by any thread.
+bool http_mpsc_queue_push(http_mpsc_queue_t *queue, const void *item);
+
+/// Copies the next item out of the queue, returns false if the queue is
+///  empty. May only be called by the consumer thread.
+bool http_mpsc_queue_pop(http_mpsc_queue_t *queue, void *item);
+
+#endif
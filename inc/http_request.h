@@ -30,10 +30,23 @@
 #include "http_url.h"
 #include "http_version.h"
 
+/// The maximum number of headers of a request, their slices are kept inside
+/// the request itself.
+#define HTTP_REQUEST_MAX_HEADERS 64
+
 #define http_request_get_state(req) ((req)->state)
 #define http_request_get_version(REQUEST) ((REQUEST)->version)
 #define http_request_get_method(REQUEST) ((REQUEST)->method)
 
+/// Gets the first byte of a slice of the request, the slices are not
+///  terminated, so their length must be used.
+#define http_request_slice(REQUEST, SLICE)                                     \
+  http_slice_ptr((REQUEST)->buffer, SLICE)
+
+#define http_request_get_path(REQUEST)                                         \
+  http_request_slice(REQUEST, (REQUEST)->parsed_url.path)
+#define http_request_get_path_len(REQUEST) ((REQUEST)->parsed_url.path.len)
+
 typedef enum {
   HTTP_REQUEST_STATE_RECEIVING_TYPE =
       0, // The request type, path and HTTP version.
@@ -42,6 +55,15 @@ typedef enum {
   HTTP_REQUEST_STATE_DONE               // Preparing response ...
 } http_request_state_t;
 
+typedef struct {
+  http_slice_t key;
+  http_slice_t value;
+} http_request_header_t;
+
+/// An HTTP request, the method, target and headers are slices of the receive
+/// buffer of the connection, which holds the head until the request is done.
+/// The method, the target, and the header keys and values are also
+/// terminated in place, the path and query are not.
 typedef struct {
   http_request_state_t state;
   uint32_t flags;
@@ -50,10 +72,15 @@ typedef struct {
   http_version_t version;
   http_content_type_t content_type;
   //--//
-  http_headers_t *headers;
+  uint8_t *buffer;
+  size_t head_len;
+  //--//
+  http_slice_t method_name;
+  http_slice_t target;
   http_url_t parsed_url;
   //--//
-  char *url;
+  http_request_header_t headers[HTTP_REQUEST_MAX_HEADERS];
+  uint32_t header_count;
   //--//
   http_segmented_buffer_t *body;
   size_t received_body_size;
@@ -66,17 +93,41 @@ http_request_t *http_request_create(void);
 /// Frees an HTTP request.
 int32_t http_request_free(http_request_t **req);
 
+/// Resets an HTTP request so it can receive the next request, the body
+/// segments are kept, so the next request on the connection can reuse their
+/// memory.
+void http_request_reset(http_request_t *request);
+
 /// Prints HTTP request info.
 void http_request_print(http_request_t *request);
 
+/// Finds the header with the specified key (case insensitive), returns NULL
+/// if the request does not have it.
+const http_request_header_t *
+http_request_find_header(const http_request_t *request, const char *key);
+
+/// Gets the next token of the line which ends at end, the spaces before it
+/// are skipped. Returns -1 if there are no tokens left.
+int32_t __http_request_next_token(http_request_t *request, size_t *offset,
+                                  size_t end, http_slice_t *token);
+
 /// Updates the HTTP request when type state is specified.
-int32_t __http_request_update__type(http_request_t *request, char *line);
+int32_t __http_request_update__type(http_request_t *request, size_t offset,
+                                    size_t len);
 
 /// Updates the HTTP request when header state is specified.
-int32_t __http_request_update__headers(http_request_t *request, char *line);
-
-/// Updates the HTTP request with the specified data, this will process it
-/// further.
-int32_t http_request_update(http_request_t *request, uint8_t *data);
+int32_t __http_request_update__headers(http_request_t *request, size_t offset,
+                                       size_t len);
+
+/// Parses the value of a Content-Length header, which must consist of digits
+/// only. Returns -1 if it does not, or if it does not fit.
+int32_t __http_request_parse_content_length(http_request_t *request,
+                                            http_slice_t value,
+                                            size_t *result);
+
+/// Updates the HTTP request with the line of len bytes at offset in the
+/// buffer, without its line terminator, this will process it further.
+int32_t http_request_update(http_request_t *request, uint8_t *buffer,
+                            size_t offset, size_t len);
 
 #endif
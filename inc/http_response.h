@@ -30,7 +30,15 @@
 #include "http_method.h"
 #include "http_version.h"
 #include "http_code.h"
+#include "http_date.h"
 #include "http_accept_range.h"
+#include "http_file_cache.h"
+#include "http_response_cache.h"
+#include "http_status_line.h"
+
+/// The maximum number of default headers, these are rendered once into a
+///  single block which every response shares.
+#define HTTP_RESPONSE_MAX_DEFAULT_HEADERS 8
 
 #define http_response_set_code(RESPONSE, CODE) ((RESPONSE)->code = (CODE))
 #define http_response_set_method(RESPONSE, METHOD) ((RESPONSE)->method = (METHOD))
@@ -58,31 +66,91 @@ http_response_t *http_response_new (void);
 /// Frees an HTTP response.
 int32_t http_response_free (http_response_t **response);
 
+/// Resets an HTTP response so it can be used for the next request on the
+///  same connection, the header nodes are kept for reuse.
+void http_response_reset (http_response_t *response);
+
 /// Adds the X-Server header to the specified headers.
 int32_t __http_add_x_server_header (char *buffer, size_t buffer_size, http_headers_t *headers);
 
-/// Adds the Date header to the specified headers.
-int32_t __http_add_date_header (char *buffer, size_t buffer_size, http_headers_t *headers);
+/// Appends the Date header with the date of the current second to the
+///  output buffer, without enqueueing it.
+int32_t __http_response_serialize_date (http_socket_t *socket);
 
 /// Gets called at startup of server, prepares the default headers.
 int32_t http_response_prepare_default_headers (void);
 
+/// Renders the default headers once into a single block, in the same format
+///  they're written to the socket, and remembers where every header starts.
+int32_t __http_response_render_default_headers (void);
+
 /// Gets called to free the default headers.
 int32_t http_response_free_default_headers (void);
 
-/// Adds the default HTTP headers.
-int32_t __http_response_add_default_headers (http_response_t *response);
+/// Checks if the headers of the response contain one with the specified key,
+///  which then takes the place of the default header.
+bool __http_response_overrides (http_response_t *response, const char *key);
+
+/// Adds the part of the default header block between the specified offsets
+///  to the response, either by reference or copied into the output buffer.
+int32_t __http_response_splice_default_range (http_socket_t *socket, size_t start, size_t end, bool copy);
+
+/// Adds the default headers the response does not override, the ones next
+///  to each other are added as a single part of the block.
+int32_t __http_response_splice_default_headers (http_socket_t *socket, http_response_t *response, bool copy);
+
+/// Gets called at startup of server, prepares the caches of the static
+///  files and of the complete responses of the small ones.
+int32_t http_response_prepare_caches (void);
+
+/// Gets called to free the caches, this closes the cached files.
+void http_response_free_caches (void);
+
+/// Releases the cached file of a write operation, once it's been sent.
+void __http_response_release_file (void *entry);
+
+/// Releases the cached response of a write operation, once it's been sent.
+void __http_response_release_cached (void *entry);
 
 /// Writes an HTTP response head.
 int32_t http_write_response_head (http_socket_t *socket, http_response_t *response);
 
-/// Writes the HTTP response headers.
+/// Serializes the status line into the output buffer, without enqueueing it.
+int32_t __http_response_serialize_head (http_socket_t *socket, http_response_t *response);
+
+/// Formats the status line of a code without a reason phrase into the output
+///  buffer, without enqueueing it.
+int32_t __http_response_format_head (http_socket_t *socket, http_response_t *response);
+
+/// Writes the HTTP response headers, the default headers and the Date
+///  header, and the empty line which terminates them.
 int32_t http_response_write_headers (http_socket_t *socket, http_response_t *response);
 
+/// Writes the HTTP response headers, the default headers, the Date header
+///  followed by an already rendered block of headers, and the empty line
+///  which terminates them. The default headers are sent from their block.
+int32_t __http_response_write_headers (http_socket_t *socket, http_response_t *response, const char *block, size_t block_len);
+
+/// Serializes the HTTP response headers into the output buffer, without
+///  enqueueing them.
+int32_t __http_response_serialize_headers (http_socket_t *socket, http_response_t *response);
+
 /// Writes an text response to the client.
 int32_t http_response_write_text (http_socket_t *socket, http_response_t *response, http_content_type_t type, const char *text);
 
-/// Writes an file to the client.
+/// Builds the cached response of a small file, the head is serialized into
+///  the output buffer of the socket, and moved from there into the entry.
+http_response_cache_entry_t *__http_response_cache_build (http_socket_t *socket, http_response_t *response, const char *path, http_file_cache_entry_t *file);
+
+/// Writes a cached response, the head and the body are sent from the entry
+///  itself, with the Date header in between, all in a single gather write.
+///  Returns a negative value other than -1 if this fails.
+int32_t __http_response_write_cached (http_socket_t *socket, http_response_t *response, http_response_cache_entry_t *entry);
+
+/// Writes an file to the client, the file comes from the static file cache,
+///  and small files from the response cache. Returns -1 if the file can not
+///  be served, nothing has been written then, any other negative value means
+///  writing the response failed after all.
 int32_t http_response_write_file (http_socket_t *socket, http_response_t *response, const char *path);
 
 #endif
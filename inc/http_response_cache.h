@@ -0,0 +1,158 @@
+/*
+    Copyright 2021 Luke A.C.A. Rieff
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/*
+    HTTP Response Cache: Keeps the complete serialized responses of small
+     files, the head and the body in one immutable buffer. The cache is
+     shared by all pools, and mostly read, a hit only takes the read lock and
+     marks the entry for the CLOCK eviction.
+*/
+
+#ifndef _HTTP_RESPONSE_CACHE_H
+#define _HTTP_RESPONSE_CACHE_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "http_common.h"
+#include "http_file_cache.h"
+#include "http_timer_wheel.h"
+
+/// The number of bytes all the cached responses may take together, and the
+///  largest file whose response is cached.
+#define HTTP_RESPONSE_CACHE_SIZE (1024 * 1024)
+#define HTTP_RESPONSE_CACHE_MAX_FILE_SIZE (16 * 1024)
+
+/// The maximum number of cached responses, and the number (power of two) of
+///  hash buckets.
+#define HTTP_RESPONSE_CACHE_MAX_ENTRIES 256
+#define HTTP_RESPONSE_CACHE_BUCKETS 256
+
+/// The number of milliseconds a response is trusted, after that the next hit
+///  checks if it's still built from the same file.
+#define HTTP_RESPONSE_CACHE_TTL 2000
+
+///////////////////////////////////////////////////////////////////////////////
+// Data Types
+///////////////////////////////////////////////////////////////////////////////
+
+/// A cached response, the path and the bytes are stored right after it. The
+///  bytes are the head without the terminating empty line, followed by that
+///  empty line and the body, so the Date header can be sent in between.
+struct http_response_cache_entry {
+  struct http_response_cache_entry *next;
+  size_t slot;
+  //---------------------------//
+  uint64_t hash;
+  const char *path;
+  uint32_t code;
+  uint32_t version;
+  //---------------------------//
+  uint32_t refs;
+  uint8_t referenced;
+  int64_t expires;
+  //---------------------------//
+  dev_t dev;
+  ino_t ino;
+  off_t file_size;
+  struct timespec mtime;
+  //---------------------------//
+  size_t head_len;
+  size_t size;
+  uint8_t *bytes;
+};
+typedef struct http_response_cache_entry http_response_cache_entry_t;
+
+typedef struct {
+  pthread_rwlock_t lock;
+  http_response_cache_entry_t *buckets[HTTP_RESPONSE_CACHE_BUCKETS];
+  //---------------------------//
+  http_response_cache_entry_t *clock[HTTP_RESPONSE_CACHE_MAX_ENTRIES];
+  size_t count;
+  size_t hand;
+  size_t bytes;
+} http_response_cache_t;
+
+///////////////////////////////////////////////////////////////////////////////
+// HTTP Response Cache Entry
+///////////////////////////////////////////////////////////////////////////////
+
+/// Creates an entry for the response of the specified file, with room for
+///  head_len bytes of head, the empty line and the body. The body is read
+///  from the file, the head must be filled in by the caller.
+http_response_cache_entry_t *
+http_response_cache_entry_new(const char *path, uint32_t code,
+                              uint32_t version, size_t head_len,
+                              http_file_cache_entry_t *file);
+
+/// Checks if the entry has been built from the file of the file cache entry.
+bool http_response_cache_entry_matches(http_response_cache_entry_t *entry,
+                                       http_file_cache_entry_t *file);
+
+/// Trusts the entry for another period.
+void http_response_cache_entry_refresh(http_response_cache_entry_t *entry);
+
+/// Takes an extra reference to an entry.
+void http_response_cache_entry_retain(http_response_cache_entry_t *entry);
+
+/// Drops a reference to an entry, the last one frees it.
+void http_response_cache_entry_release(http_response_cache_entry_t *entry);
+
+///////////////////////////////////////////////////////////////////////////////
+// HTTP Response Cache
+///////////////////////////////////////////////////////////////////////////////
+
+/// Hashes the key of a cached response.
+uint64_t __http_response_cache_hash(const char *path, uint32_t code,
+                                    uint32_t version);
+
+/// Finds the entry with the specified key, the cache must be locked.
+http_response_cache_entry_t *
+__http_response_cache_find(http_response_cache_t *cache, uint64_t hash,
+                           const char *path, uint32_t code, uint32_t version);
+
+/// Removes an entry from the write locked cache, and drops its reference.
+void __http_response_cache_remove(http_response_cache_t *cache,
+                                  http_response_cache_entry_t *entry);
+
+/// Evicts one entry from the write locked cache, the hand skips (and clears)
+///  the entries which have been used since it last passed them.
+void __http_response_cache_evict(http_response_cache_t *cache);
+
+/// Initializes a response cache.
+int32_t http_response_cache_init(http_response_cache_t *cache);
+
+/// Frees a response cache, the entries which are still referenced are freed
+///  once they're released.
+void http_response_cache_free(http_response_cache_t *cache);
+
+/// Gets the cached response with the specified key, which the caller must
+///  release, fresh tells if it is still within its time to live. Returns
+///  NULL if it is not cached.
+http_response_cache_entry_t *
+http_response_cache_get(http_response_cache_t *cache, const char *path,
+                        uint32_t code, uint32_t version, bool *fresh);
+
+/// Inserts an entry into the cache, replacing the one with the same key, the
+///  reference of the caller stays with the caller.
+void http_response_cache_insert(http_response_cache_t *cache,
+                                http_response_cache_entry_t *entry);
+
+#endif
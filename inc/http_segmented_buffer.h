@@ -29,13 +29,17 @@
 
 #define HTTP_LINE_BUFFER_CREATE_LINE_FROM_STRING_FLAG__COPY     (1 << 0)
 
+/// The number of bytes of segment memory a cleared buffer keeps for reuse,
+///  the segments of a larger body are freed.
+#define HTTP_SEGMENTED_BUFFER_MAX_UNUSED_SIZE                   (64 * 1024)
+
 ///////////////////////////////////////////////////////////////////////////////
 // Data Types
 ///////////////////////////////////////////////////////////////////////////////
 
 struct http_segmented_buffer__segment {
     uint8_t *bytes;
-    size_t written, total;
+    size_t written, total, capacity;
     struct http_segmented_buffer__segment *next, *prev;
 };
 
@@ -44,6 +48,8 @@ typedef struct http_segmented_buffer__segment http_segmented_buffer__segment_t;
 typedef struct {
     http_segmented_buffer__segment_t *start, *end;
     size_t segment_count;
+    http_segmented_buffer__segment_t *unused;
+    size_t unused_size;
 } http_segmented_buffer_t;
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -56,6 +62,15 @@ http_segmented_buffer_t *http_segmented_buffer_create (void);
 /// Frees an http segmented buffer.
 void http_segmented_buffer_free (http_segmented_buffer_t **buffer);
 
+/// Removes all the segments of an http segmented buffer, the segments are
+///  kept on the unused list up to HTTP_SEGMENTED_BUFFER_MAX_UNUSED_SIZE bytes,
+///  so their memory can be used again, the rest is freed.
+void http_segmented_buffer_clear (http_segmented_buffer_t *buffer);
+
+/// Takes a segment which can hold size bytes, from the unused list if there
+///  is one, else it allocates a new segment.
+http_segmented_buffer__segment_t *http_segmented_buffer_take_segment (http_segmented_buffer_t *buffer, size_t size);
+
 /// Creates a new segment.
 http_segmented_buffer__segment_t *http_segmented_buffer_segment_create_from_string (const char *string);
 
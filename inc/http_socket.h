@@ -19,6 +19,7 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
 #include <malloc.h>
 #include <pthread.h>
 #include <stdarg.h>
@@ -31,31 +32,199 @@
 
 #include <arpa/inet.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 
+#include <linux/errqueue.h>
+
+#include <sched.h>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/ioctl.h>
 #include <sys/poll.h>
 #include <sys/sendfile.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
 
+#include "http_buffer_pool.h"
 #include "http_helpers.h"
+#include "http_mpsc_queue.h"
 #include "http_request.h"
 #include "http_response.h"
 #include "http_segmented_buffer.h"
+#include "http_timer_wheel.h"
+#include "http_uring.h"
 
 ///////////////////////////////////////////////////////////////////////////////
 // Flags and shit
 ///////////////////////////////////////////////////////////////////////////////
 
 #define HTTP_SERVER_SOCKET_ACCEPTOR_THREAD_CREATED (1 << 1)
+#define HTTP_SERVER_SOCKET_FLAG_POOL_LISTENERS (1 << 2)
+#define HTTP_SERVER_SOCKET_FLAG_PIN_POOLS (1 << 3)
+#define HTTP_SERVER_SOCKET_FLAG_ZEROCOPY (1 << 4)
 
-#define HTTP_SERVER_SOCKET_POOL_FLAG_SHUTDOWN (1 << 0)
+#define http_server_socket_flag_set(SOCK, FLAG) ((SOCK)->flags |= (FLAG))
+#define http_server_socket_flag_is_set(SOCK, FLAG)                             \
+  ((((SOCK)->flags) & (FLAG)) != 0)
 
-#define HTTP_SOCKET_RECV_BUFFER_SIZE 1024
+#define HTTP_SERVER_SOCKET_POOL_FLAG_SHUTDOWN (1 << 0)
+#define HTTP_SERVER_SOCKET_POOL_FLAG_PINNED (1 << 1)
+
+/// The maximum number of events returned by a single epoll_wait () call, the
+///  remaining ones will simply be reported in the next iteration.
+#define HTTP_SERVER_SOCKET_POOL_MAX_EVENTS 256
+
+/// The number of milliseconds epoll_wait () may block, this bounds how long
+///  it takes for a pool to notice the shutdown flag.
+#define HTTP_SERVER_SOCKET_POOL_WAIT_TIMEOUT 250
+
+/// The maximum number of connections a pool listener accepts per event, so
+///  a connection storm can not starve the already accepted sockets.
+#define HTTP_SERVER_SOCKET_POOL_ACCEPT_BATCH 64
+
+/// The number of submission queue entries of the io_uring engine.
+#define HTTP_SERVER_SOCKET_POOL_URING_ENTRIES 256
+
+/// The number (power of two) and size of the provided buffers which the
+///  io_uring engine receives into, these are shared by all sockets in a pool.
+#define HTTP_SERVER_SOCKET_POOL_URING_BUFFER_COUNT 128
+#define HTTP_SERVER_SOCKET_POOL_URING_BUFFER_SIZE 2048
+
+/// Builds the io_uring user data, the generation makes sure completions of
+///  a closed socket are not delivered to a new socket with the same fd.
+#define __HTTP_SOCKET_POOL_URING_USER_DATA(OP, GENERATION, FD)                 \
+  (((uint64_t)(OP) << 48) | ((uint64_t)(uint16_t)(GENERATION) << 32) |        \
+   (uint64_t)(uint32_t)(FD))
+#define __HTTP_SOCKET_POOL_URING_USER_DATA_OP(DATA) ((uint32_t)((DATA) >> 48))
+#define __HTTP_SOCKET_POOL_URING_USER_DATA_GENERATION(DATA)                    \
+  ((uint16_t)((DATA) >> 32))
+#define __HTTP_SOCKET_POOL_URING_USER_DATA_FD(DATA) ((int32_t)(uint32_t)(DATA))
+
+/// The number (power of two) of accepted sockets which may be waiting in the
+///  handoff queue of a pool, before the acceptor tries the next pool.
+#define HTTP_SERVER_SOCKET_POOL_INCOMING_QUEUE_SIZE 1024
+
+/// The number of pending write bytes which weigh as much as one connection,
+///  when the power-of-two-choices placement compares the load of two pools.
+#define HTTP_SERVER_SOCKET_POOL_LOAD_BYTES_PER_CONNECTION (64 * 1024)
+
+/// The initial size of the output buffer of a socket, which the response
+///  heads are serialized into, it doubles whenever it is too small.
+#define HTTP_SOCKET_OUTPUT_BUFFER_SIZE 512
+
+/// The number of bytes a copied binary write operation stores inside itself,
+///  instead of allocating them.
+#define HTTP_SOCKET_WRITE_OP_INLINE_SIZE 32
+
+/// The number (power of two) of write operations stored inside the socket,
+///  the queue only moves to the heap if more are pending at once.
+#define HTTP_SOCKET_WRITE_QUEUE_INLINE_SIZE 4
+
+/// The maximum number of consecutive byte write operations which are sent
+///  with a single gather write.
+#define HTTP_SOCKET_WRITE_GATHER_MAX IOV_MAX
+
+/// The number (power of two) of slots in the timer wheel of a pool, the wheel
+///  ticks at the wait timeout, so one revolution spans about two minutes.
+#define HTTP_SERVER_SOCKET_POOL_TIMER_SLOTS 512
+
+/// The timeouts (in milliseconds) of a connection, idle is between keep-alive
+///  requests, header is for the complete request head, body and write are
+///  reset whenever there is progress.
+#define HTTP_SOCKET_TIMEOUT_IDLE 15000
+#define HTTP_SOCKET_TIMEOUT_HEADER 10000
+#define HTTP_SOCKET_TIMEOUT_BODY 30000
+#define HTTP_SOCKET_TIMEOUT_WRITE 30000
+
+/// The time (in milliseconds) a closed socket may linger for its zero-copy
+///  completions before the connection is aborted, and the interval at which
+///  it checks for them.
+#define HTTP_SOCKET_TIMEOUT_LINGER 30000
+#define HTTP_SOCKET_LINGER_INTERVAL 1000
+
+/// The number of sockets allocated at once when the free list of a pool is
+///  empty, these are recycled and only freed together with the pool.
+#define HTTP_SERVER_SOCKET_POOL_SLAB_SIZE 64
+
+/// The initial size of the fd-indexed socket table of a pool, it doubles
+///  whenever a larger fd gets registered.
+#define HTTP_SERVER_SOCKET_POOL_FD_TABLE_SIZE 1024
+
+#define HTTP_SOCKET_FLAG_URING_POLLOUT (1 << 1)
+#define HTTP_SOCKET_FLAG_WRITE_READY (1 << 2)
+#define HTTP_SOCKET_FLAG_ZEROCOPY (1 << 3)
+#define HTTP_SOCKET_FLAG_URING_POLLERR (1 << 4)
+#define HTTP_SOCKET_FLAG_ZEROCOPY_LINGER (1 << 5)
+#define HTTP_SOCKET_FLAG_THROTTLED (1 << 6)
+#define HTTP_SOCKET_FLAG_URING_RECV_CANCEL (1 << 7)
+#define HTTP_SOCKET_FLAG_URING_RECV_IDLE (1 << 8)
+
+/// The number of queued output bytes from which a connection stops handling
+///  pipelined requests, and stops reading, until it is written below it.
+#define HTTP_SOCKET_PIPELINE_MAX_PENDING (256 * 1024)
+
+/// The number of remaining bytes from which an owned byte operation is sent
+///  with MSG_ZEROCOPY, below it pinning the pages costs more than the copy.
+#define HTTP_SOCKET_ZEROCOPY_THRESHOLD (16 * 1024)
+
+/// The initial number of buffers a socket can hold on to while the kernel
+///  still sends from them, it doubles whenever more are in flight.
+#define HTTP_SOCKET_ZEROCOPY_BUFFERS 8
+
+/// The initial number of completion ranges a socket keeps while an earlier
+///  send call has not been completed, it doubles whenever more arrive.
+#define HTTP_SOCKET_ZEROCOPY_RANGES 4
+
+/// The number of bytes a connection may write per event loop iteration,
+///  before the other connections of the pool get their turn.
+#define HTTP_SOCKET_WRITE_BUDGET (64 * 1024)
+
+/// The results of writing an operation: the socket buffer is full, the
+///  operation has been written completely, or the budget ran out before it.
+#define HTTP_SOCKET_WRITE_OP_BLOCKED 0
+#define HTTP_SOCKET_WRITE_OP_DONE 1
+#define HTTP_SOCKET_WRITE_OP_PARTIAL 2
+
+/// The size of the first receive buffer a connection takes, if a request head
+///  does not fit it grows through the size classes of the buffer pool.
+#define HTTP_SOCKET_RECV_BUFFER_SIZE HTTP_BUFFER_POOL_MIN_SIZE
 
 ///////////////////////////////////////////////////////////////////////////////
 // Data Types
 ///////////////////////////////////////////////////////////////////////////////
 
+typedef enum {
+  HTTP_SERVER_SOCKET_POOL_ENGINE_EPOLL = 0, /* Edge-triggered epoll */
+  HTTP_SERVER_SOCKET_POOL_ENGINE_IO_URING   /* Batched io_uring */
+} http_server_socket_pool_engine_t;
+
+typedef enum {
+  HTTP_SERVER_SOCKET_PLACEMENT_ROUND_ROBIN = 0,  /* Next pool in line */
+  HTTP_SERVER_SOCKET_PLACEMENT_LEAST_CONNECTIONS, /* Fewest connections */
+  HTTP_SERVER_SOCKET_PLACEMENT_POWER_OF_TWO,      /* Less loaded of two */
+  HTTP_SERVER_SOCKET_PLACEMENT_ADDRESS_HASH       /* Hash of client address */
+} http_server_socket_placement_t;
+
+typedef enum {
+  HTTP_SOCKET_POOL_URING_OP_RECV = 1, /* Multishot receive */
+  HTTP_SOCKET_POOL_URING_OP_POLLOUT,  /* Writability poll */
+  HTTP_SOCKET_POOL_URING_OP_WAKE,     /* Pool wakeup eventfd */
+  HTTP_SOCKET_POOL_URING_OP_ACCEPT,   /* Multishot accept */
+  HTTP_SOCKET_POOL_URING_OP_POLLERR,  /* Error queue poll */
+  HTTP_SOCKET_POOL_URING_OP_CANCEL    /* Receive cancellation */
+} http_socket_pool_uring_op_t;
+
+typedef enum {
+  HTTP_SOCKET_TIMER_NONE = 0, /* Not armed */
+  HTTP_SOCKET_TIMER_IDLE,     /* Waiting for the next request */
+  HTTP_SOCKET_TIMER_HEADER,   /* Receiving the request head */
+  HTTP_SOCKET_TIMER_BODY,     /* Receiving the request body */
+  HTTP_SOCKET_TIMER_WRITE,    /* Writing the response */
+  HTTP_SOCKET_TIMER_LINGER    /* Waiting for zero-copy completions */
+} http_socket_timer_kind_t;
+
 typedef enum {
   HTTP_SOCKET_WRITE_OP_BYTES, /* Large Binary Buffer */
   HTTP_SOCKET_WRITE_OP_FILE   /* Read All From File */
@@ -64,6 +233,14 @@ typedef enum {
 #define HTTP_SOCKET_WRITE_OP_FLAG__CLOSE_SOCK_AFTER (1 << 0)
 #define HTTP_SOCKET_WRITE_OP_FLAG__FREE_BYTES (1 << 1)
 #define HTTP_SOCKET_WRITE_OP_FLAG__CLOSE_FD (1 << 2)
+#define HTTP_SOCKET_WRITE_OP_FLAG__OUTPUT (1 << 3)
+#define HTTP_SOCKET_WRITE_OP_FLAG__INLINE (1 << 4)
+#define HTTP_SOCKET_WRITE_OP_FLAG__SPLICE (1 << 5)
+#define HTTP_SOCKET_WRITE_OP_FLAG__ZEROCOPY (1 << 6)
+
+/// Gets called when an operation is freed, to release a resource it shares
+///  with others, for example a cached file.
+typedef void (*http_socket_write_op_release_t)(void *);
 
 /// Doing all in one structure to avoid too-small memory allocations, and after
 /// all
@@ -73,16 +250,35 @@ struct http_socket_write_op {
   uint32_t flags;
   //---------------------------//
   uint8_t *bytes;
+  size_t output_offset;
   size_t size;
   size_t bytes_written;
-  FILE *file;
+  int32_t fd;
   off_t file_offset;
+  off_t file_end;
+  int32_t pipe[2];
+  size_t pipe_level;
+  uint32_t zerocopy_id;
+  http_socket_write_op_release_t release;
+  void *release_arg;
   //---------------------------//
-  struct http_socket_write_op *next;
-  struct http_socket_write_op *prev;
+  uint8_t inline_bytes[HTTP_SOCKET_WRITE_OP_INLINE_SIZE];
 };
 typedef struct http_socket_write_op http_socket_write_op_t;
 
+/// A buffer which has been sent with MSG_ZEROCOPY, it may only be freed once
+///  the kernel completed the send call with the specified id.
+typedef struct {
+  uint8_t *bytes;
+  uint32_t id;
+} http_socket_zerocopy_buffer_t;
+
+/// A range of send calls the kernel completed ahead of an earlier one.
+typedef struct {
+  uint32_t first;
+  uint32_t last;
+} http_socket_zerocopy_range_t;
+
 struct http_socket {
   struct sockaddr_in address;
   //---------------------------//
@@ -90,35 +286,117 @@ struct http_socket {
   int32_t fd;
   int64_t creation_time;
   uint32_t flags;
+  uint16_t generation;
   //---------------------------//
   struct http_socket *next;
   struct http_socket *prev;
-  http_socket_write_op_t *write_start;
-  http_socket_write_op_t *write_end;
+  struct http_socket *ready_next;
+  struct http_socket *ready_prev;
+  http_socket_write_op_t *write_ops;
+  size_t write_ops_capacity;
+  size_t write_head;
+  size_t write_tail;
   size_t n_pending_write_ops;
+  size_t write_bytes_pending;
+  size_t write_bytes_accounted;
+  size_t bytes_sent;
+  //---------------------------//
+  http_timer_t timer;
+  size_t timer_progress;
+  int64_t linger_deadline;
   //---------------------------//
   size_t recv_buffer_level;
+  size_t recv_buffer_size;
   uint8_t *recv_buffer;
+  uint8_t *recv_backlog;
+  size_t recv_backlog_size;
+  //---------------------------//
+  size_t output_level;
+  size_t output_size;
+  uint8_t *output;
+  //---------------------------//
+  http_socket_zerocopy_buffer_t *zerocopy_buffers;
+  size_t zerocopy_capacity;
+  size_t zerocopy_head;
+  size_t zerocopy_tail;
+  uint32_t zerocopy_next;
+  uint32_t zerocopy_done;
+  http_socket_zerocopy_range_t *zerocopy_ranges;
+  size_t zerocopy_ranges_capacity;
+  size_t zerocopy_n_ranges;
   //---------------------------//
   http_request_t *request;
+  http_response_t *response;
+  //---------------------------//
+  http_socket_write_op_t write_ops_inline[HTTP_SOCKET_WRITE_QUEUE_INLINE_SIZE];
 };
 
 typedef struct http_socket http_socket_t;
 
+/// A block of sockets, all allocated with a single allocation.
+struct http_socket_slab {
+  struct http_socket_slab *next;
+  http_socket_t sockets[HTTP_SERVER_SOCKET_POOL_SLAB_SIZE];
+};
+typedef struct http_socket_slab http_socket_slab_t;
+
+/// A connection accepted by the acceptor, on its way to a pool, the pool
+///  itself turns it into a socket.
+typedef struct {
+  int32_t fd;
+  struct sockaddr_in address;
+} http_server_socket_pool__incoming_t;
+
 typedef void (*http_server_callback_t)(http_socket_t *, const http_request_t *,
                                        http_response_t *);
 
+/// The load of a pool, these are updated and read with atomics so the
+///  acceptor never has to take the pool mutex, and live on their own cache
+///  line since the acceptor reads them for every connection.
+typedef struct {
+  size_t connections;
+  size_t write_bytes;
+} __attribute__((aligned(64))) http_server_socket_pool_load_t;
+
 typedef struct {
   pthread_t thread;
   pthread_mutex_t mutex;
 
+  http_server_socket_pool_load_t load;
+
   uint32_t socket_count;
   http_socket_t *start, *end;
 
+  http_socket_t **sockets_by_fd;
+  size_t sockets_by_fd_size;
+
   uint32_t flags;
 
+  // Whether accepted sockets get zero-copy sends, the pool thread clears it
+  //  when the kernel refuses, so it's kept out of the shared flags.
+  bool zerocopy;
+
   size_t max_socket_count;
-  struct pollfd *fds;
+  int32_t cpu;
+  http_server_socket_pool_engine_t engine;
+  int32_t listen_fd;
+  //---------------------------//
+  http_mpsc_queue_t incoming;
+  int32_t wake_fd;
+  //---------------------------//
+  int32_t epoll_fd;
+  struct epoll_event *events;
+  //---------------------------//
+  http_uring_t ring;
+  uint16_t generation;
+  //---------------------------//
+  http_timer_wheel_t timers;
+  http_buffer_pool_t buffers;
+  //---------------------------//
+  http_socket_slab_t *slabs;
+  http_socket_t *free_sockets;
+  //---------------------------//
+  http_socket_t *ready_start, *ready_end;
 } http_server_socket_pool_t;
 
 typedef struct {
@@ -128,11 +406,13 @@ typedef struct {
 
   http_server_socket_pool_t **pools;
   size_t thread_pool_count;
+  http_server_socket_pool_engine_t engine;
 
-  pthread_mutex_t acceptor_mutex;
   pthread_t acceptor_thread;
 
   size_t thread_pool_register_next;
+  http_server_socket_placement_t placement;
+  uint32_t placement_random;
 
   http_server_callback_t callback;
 } http_server_socket_t;
@@ -146,50 +426,141 @@ typedef struct {
 // HTTP Socket Write Operation
 ///////////////////////////////////////////////////////////////////////////////
 
-/// Creates an file write operation, for the specified file path.
-http_socket_write_op_t *http_socket_write_op_create__file(const char *path);
-
-/// Creates an binary write operation where the memory get's either copied, or
-/// just referenced.
-http_socket_write_op_t *http_socket_write_op_create__binary(uint8_t *data,
-                                                            size_t size,
-                                                            bool should_copy);
-
-/// Creates an write operation.
-http_socket_write_op_t *
-http_socket_write_op_create(http_socket_write_op_type_t type, void *data,
-                            uint32_t flags);
+/// Initializes an file write operation, which sends length bytes starting at
+///  offset of the specified file descriptor.
+void http_socket_write_op_create__fd(http_socket_write_op_t *op, int32_t fd,
+                                     off_t offset, off_t length,
+                                     uint32_t flags);
+
+/// Initializes an file write operation, for the complete file at the
+///  specified path.
+int32_t http_socket_write_op_create__file(http_socket_write_op_t *op,
+                                          const char *path);
+
+/// Initializes an binary write operation where the memory get's either
+/// copied, or just referenced. Small copies are stored inside the operation.
+int32_t http_socket_write_op_create__binary(http_socket_write_op_t *op,
+                                            uint8_t *data, size_t size,
+                                            bool should_copy);
+
+/// Initializes an write operation.
+void http_socket_write_op_create(http_socket_write_op_t *op,
+                                 http_socket_write_op_type_t type, void *data,
+                                 uint32_t flags);
+
+/// Frees the resources of an write operation.
+int32_t http_socket_write_op_free(http_socket_write_op_t *op);
+
+/// Writes an file to the socket through a pipe, this is the fallback for
+///  files which do not support sendfile, at most budget bytes are written.
+int32_t __http_socket_write_op_write__splice(http_socket_t *socket,
+                                             http_socket_write_op_t *op,
+                                             size_t budget);
+
+/// Writes an file to the socket, at most budget bytes are written. The
+///  offsets are 64-bit, so files larger than 2 GiB are streamed as well.
+int32_t __http_socket_write_op_write__file(http_socket_t *socket,
+                                           http_socket_write_op_t *op,
+                                           size_t budget);
 
-/// Frees an write operation.
-int32_t http_socket_write_op_free(http_socket_write_op_t **op);
+/// Gets the bytes of a byte operation, these are either owned by the operation
+///  (possibly inline), or stored in the output buffer of the socket.
+uint8_t *__http_socket_write_op_bytes(http_socket_t *socket,
+                                      http_socket_write_op_t *op);
 
-/// Writes an file to the socket.
-int32_t __http_socket_write_op_write__file(http_socket_t *socket,
-                                           http_socket_write_op_t *op);
+/// Checks if a byte operation is sent with MSG_ZEROCOPY, which is the case for
+///  large buffers owned by the operation, once the socket has it enabled.
+bool __http_socket_write_op_is_zerocopy(http_socket_t *socket,
+                                        http_socket_write_op_t *op);
 
-/// Writes an bytes to the socket.
+/// Writes an bytes to the socket, at most budget bytes are written.
 int32_t __http_socket_write_op_write__bytes(http_socket_t *socket,
-                                            http_socket_write_op_t *op);
+                                            http_socket_write_op_t *op,
+                                            size_t budget);
 
-/// Writes the specified operation.
+/// Writes the consecutive byte operations at the front of the queue with a
+///  single gather write, at most budget bytes are written. The completely
+///  written operations are dequeued.
+int32_t __http_socket_write_op_write__gather(http_socket_t *socket,
+                                             size_t budget);
+
+/// Writes the specified operation, at most budget bytes are written.
 int32_t http_socket_write_op_write(http_socket_t *socket,
-                                   http_socket_write_op_t *op);
+                                   http_socket_write_op_t *op, size_t budget);
+
+///////////////////////////////////////////////////////////////////////////////
+// HTTP Socket Write Queue
+///////////////////////////////////////////////////////////////////////////////
+
+/// Gets the operation at the specified (unmasked) position of the queue.
+http_socket_write_op_t *__http_socket_write_queue_at(http_socket_t *socket,
+                                                     size_t i);
 
-/// Enqueues an write operation when there is nothing else inside.
-void __http_socket_enqueue_write_op__single(http_socket_t *socket,
-                                            http_socket_write_op_t *op);
+/// Gets the oldest operation of the queue, which is the one being written.
+http_socket_write_op_t *http_socket_write_queue_front(http_socket_t *socket);
 
-/// Enqueues an write operation when there is already one inside.
-void __http_socket_enqueue_write_op__multiple(http_socket_t *socket,
-                                              http_socket_write_op_t *op);
+/// Gets the newest operation of the queue.
+http_socket_write_op_t *http_socket_write_queue_back(http_socket_t *socket);
 
-/// Enqueues an write operation to http socket.
-void http_socket_enqueue_write_op(http_socket_t *socket,
-                                  http_socket_write_op_t *op);
+/// Doubles the capacity of the write queue, the first time the operations
+///  move from the socket itself to the heap.
+int32_t __http_socket_write_queue_grow(http_socket_t *socket);
 
-/// Dequeues the last element from the queue, most likely called when written.
+/// Resets the write queue of a socket, this makes it use the operations
+///  inside the socket, unless it already grew to the heap.
+void __http_socket_write_queue_init(http_socket_t *socket);
+
+/// Frees the write queue of a socket, including the resources of the
+///  operations which are still inside.
+void __http_socket_write_queue_free(http_socket_t *socket);
+
+/// Enqueues an write operation to http socket, the operation is copied into
+///  the queue, which only allocates when it has to grow.
+int32_t http_socket_enqueue_write_op(http_socket_t *socket,
+                                     const http_socket_write_op_t *op);
+
+/// Dequeues the oldest operation from the queue, most likely called when
+///  written.
 void http_socket_dequeue_write_op(http_socket_t *socket);
 
+///////////////////////////////////////////////////////////////////////////////
+// HTTP Socket Output Buffer
+///////////////////////////////////////////////////////////////////////////////
+
+/// Makes sure the output buffer of the socket can hold size more bytes, and
+///  returns where to write them.
+uint8_t *http_socket_output_reserve(http_socket_t *socket, size_t size);
+
+/// Appends the specified bytes to the output buffer of the socket.
+int32_t http_socket_output_append(http_socket_t *socket, const void *data,
+                                  size_t size);
+
+/// Enqueues the bytes which have been appended to the output buffer since
+///  offset, this extends the previous operation if it ends at offset.
+int32_t http_socket_enqueue_output(http_socket_t *socket, size_t offset);
+
+///////////////////////////////////////////////////////////////////////////////
+// HTTP Socket Zero-Copy
+///////////////////////////////////////////////////////////////////////////////
+
+/// Holds on to a buffer which has been sent with MSG_ZEROCOPY, until the
+///  kernel completed the send call with the specified id.
+int32_t __http_socket_zerocopy_retain(http_socket_t *socket, uint8_t *bytes,
+                                      uint32_t id);
+
+/// Frees the retained buffers whose send calls have been completed.
+void __http_socket_zerocopy_release(http_socket_t *socket);
+
+/// Marks the send calls with the ids first up to last as completed, ranges
+///  beyond one which did not complete yet are kept until it did.
+int32_t __http_socket_zerocopy_complete_range(http_socket_t *socket,
+                                              uint32_t first, uint32_t last);
+
+/// Reads the zero-copy completions from the error queue of the socket, and
+///  frees the buffers the kernel is done with. Returns -1 if the socket has
+///  an actual error.
+int32_t http_socket_zerocopy_complete(http_socket_t *socket);
+
 ///////////////////////////////////////////////////////////////////////////////
 // HTTP Socket
 ///////////////////////////////////////////////////////////////////////////////
@@ -208,9 +579,15 @@ int32_t http_socket_free(http_socket_t **socket);
 void __http_server_socket_log(http_server_socket_t *sock, const char *format,
                               ...);
 
-/// Creates an new HTTP server socket instance.
+/// Gets the CPUs the process may run on, and returns how many there are.
+size_t __http_server_socket__allowed_cpus(cpu_set_t *set);
+
+/// Creates an new HTTP server socket instance, the engine specifies which
+///  mechanism the socket pools use to wait for events, if the thread pool
+///  count is zero one pool per allowed CPU is created.
 http_server_socket_t *
 http_server_socket_create(size_t thread_pool_count, size_t max_socket_count,
+                          http_server_socket_pool_engine_t engine,
                           http_server_callback_t callback);
 
 /// Initializes an HTTP server socket instance.
@@ -226,7 +603,8 @@ int32_t http_server_socket_configure(http_server_socket_t *sock, uint16_t port,
 /// Binds the specified HTTP server socket instance.
 int32_t http_server_socket_bind(http_server_socket_t *sock);
 
-/// Listens the specified HTTP server socket instance.
+/// Listens the specified HTTP server socket instance, when pool listeners are
+///  enabled every pool gets its own listening socket instead.
 int32_t http_server_socket_listen(http_server_socket_t *sock);
 
 /// Stops an HTTP server socket instance.
@@ -238,35 +616,100 @@ int32_t http_server_socket_stop(http_server_socket_t *sock);
 
 /// Creates new HTTP server socket pool.
 http_server_socket_pool_t *
-__http_server_socket_pool_create(size_t max_socket_count);
+__http_server_socket_pool_create(size_t max_socket_count,
+                                 http_server_socket_pool_engine_t engine);
+
+/// Creates the epoll instance of an HTTP server socket pool.
+int32_t __http_server_socket_pool_create__epoll(http_server_socket_pool_t *pool);
+
+/// Creates the io_uring instance of an HTTP server socket pool.
+int32_t __http_server_socket_pool_create__uring(http_server_socket_pool_t *pool);
 
 /// Initializes HTTP server socket pool.
 int32_t __http_server_socket_pool_init(http_server_socket_pool_t *pool);
 
-/// Starts HTTP server socket pool.
+/// Starts HTTP server socket pool, pinned to its CPU if the server has pool
+///  pinning enabled, and with zero-copy sends if the server has those.
 int32_t __http_server_socket_pool_start(http_server_socket_t *sock,
                                         http_server_socket_pool_t *pool);
 
+/// Creates the SO_REUSEPORT listening socket of a pool, and registers it to
+///  the engine of the pool so it accepts inside its own event loop.
+int32_t __http_server_socket_pool_listen(http_server_socket_t *sock,
+                                         http_server_socket_pool_t *pool);
+
 /// Stops HTTP server socket pool.
 int32_t __http_server_socket_pool_stop(http_server_socket_pool_t *pool);
 
 /// Frees HTTP server socket pool.
 void __http_server_socket_pool_free(http_server_socket_pool_t **pool);
 
+/// Takes a socket from the free list of the pool, allocates a new slab when
+///  the free list is empty. The socket comes with a reset request.
+http_socket_t *__http_socket_pool__alloc_socket(http_server_socket_pool_t *pool);
+
+/// Gives a socket back to the free list of the pool.
+void __http_socket_pool__release_socket(http_server_socket_pool_t *pool,
+                                        http_socket_t *socket);
+
 ///////////////////////////////////////////////////////////////////////////////
 
 /// Processes the request body line-wise, this is done for headers and type.
+///  The head stays in the receive buffer until the request is done, since the
+///  request refers to it, so only the lines after the parsed ones are read.
 int32_t
 __http_socket_pool__on_readable__process_lines(http_server_socket_t *sock,
                                                http_server_socket_pool_t *pool,
                                                http_socket_t *socket);
 
-/// Gets called when an socket can be written to.
+/// Gets called when an socket can be written to, it writes until the socket
+///  buffer is full, or the write budget of this iteration is spent. In the
+///  latter case the socket continues from the ready list, after the others.
 int32_t __http_socket_pool__on_writable(http_server_socket_t *sock,
                                         http_server_socket_pool_t *pool,
                                         http_socket_t *socket);
 
-/// Gets called when an socket can be read from.
+/// Appends a socket to the ready list of the pool, these still have data to
+///  write, and are writable, but have spent their write budget.
+void __http_socket_pool__ready_push(http_server_socket_pool_t *pool,
+                                    http_socket_t *socket);
+
+/// Removes a socket from the ready list of the pool, if it is on there.
+void __http_socket_pool__ready_remove(http_server_socket_pool_t *pool,
+                                      http_socket_t *socket);
+
+/// Gives every socket on the ready list another write budget, in the order
+///  they ran out of it. The ones which spend it again go to the back.
+void __http_socket_pool__flush_ready(http_server_socket_t *sock,
+                                     http_server_socket_pool_t *pool);
+
+/// Stops handling the requests of a socket while its responses pile up, with
+///  io_uring its receive is cancelled as well.
+int32_t __http_socket_pool__throttle(http_server_socket_pool_t *pool,
+                                     http_socket_t *socket);
+
+/// Resumes a throttled socket once its queued output dropped below the
+///  limit, handles the requests it already received and continues reading.
+int32_t __http_socket_pool__unthrottle(http_server_socket_t *sock,
+                                       http_server_socket_pool_t *pool,
+                                       http_socket_t *socket);
+
+/// Processes the data inside of the receive buffer.
+int32_t __http_socket_pool__on_readable__process(http_server_socket_t *sock,
+                                                 http_server_socket_pool_t *pool,
+                                                 http_socket_t *socket);
+
+/// Makes sure the socket has a receive buffer with free space, takes one from
+///  the pool or grows it, returns -1 if it's full at the largest size.
+int32_t __http_socket_pool__reserve_recv_buffer(http_server_socket_pool_t *pool,
+                                                http_socket_t *socket);
+
+/// Gives the receive buffer of the socket back to the pool, if it's empty.
+void __http_socket_pool__release_recv_buffer(http_server_socket_pool_t *pool,
+                                             http_socket_t *socket);
+
+/// Gets called when an socket can be read from, reads until EAGAIN since the
+///  sockets are registered edge-triggered.
 int32_t __http_socket_pool__on_readable(http_server_socket_t *sock,
                                         http_server_socket_pool_t *pool,
                                         http_socket_t *socket);
@@ -280,6 +723,10 @@ void __http_socket_pool_register_socket__empty_pool(
 void __http_socket_pool_register_socket__not_empty_pool(
     http_server_socket_pool_t *pool, http_socket_t *socket);
 
+/// Makes sure the fd-indexed socket table can hold the specified fd.
+int32_t __http_socket_pool__reserve_fd(http_server_socket_pool_t *pool,
+                                       int32_t fd);
+
 /// Gets an socket by fd.
 http_socket_t *
 __http_socket_pool__get_socket_by_fd(http_server_socket_pool_t *pool,
@@ -289,10 +736,108 @@ __http_socket_pool__get_socket_by_fd(http_server_socket_pool_t *pool,
 void __http_socket_pool_unregister__by_fd(http_server_socket_pool_t *pool,
                                           int32_t fd);
 
-/// Registers an socket to the specified pool
-void __http_socket_pool_register_socket(http_server_socket_pool_t *pool,
+/// Registers an socket to the specified pool, and adds it to the epoll
+///  instance, returns -1 if the pool is full.
+int32_t __http_socket_pool_register_socket(http_server_socket_pool_t *pool,
+                                           http_socket_t *socket);
+
+/// Updates the socket after its events, publishes its writes and timeout, and
+///  with io_uring posts the polls it needs. The epoll interest never changes.
+int32_t __http_socket_pool__update_events(http_server_socket_pool_t *pool,
+                                          http_socket_t *socket);
+
+/// Arms the timer of the socket for what it is doing now, the header timer is
+///  only armed once per request, the body and write timers on progress.
+void __http_socket_pool__update_timer(http_server_socket_pool_t *pool,
+                                      http_socket_t *socket);
+
+/// Gets called by the timer wheel when the timer of a socket expired.
+void __http_socket_pool__on_timeout(http_timer_t *timer, void *arg);
+
+/// Closes the specified socket, and unregisters it from the pool. A socket
+///  whose zero-copy buffers are still in use by the kernel lingers instead.
+void __http_socket_pool__close_socket(http_server_socket_pool_t *pool,
+                                      http_socket_t *socket);
+
+/// Keeps a closing socket around until the kernel completed its zero-copy
+///  buffers, returns -1 if there is nothing to wait for.
+int32_t __http_socket_pool__linger_socket(http_server_socket_pool_t *pool,
+                                          http_socket_t *socket);
+
+/// Reads the zero-copy completions of a lingering socket, and closes it once
+///  all of its buffers are released.
+void __http_socket_pool__on_linger(http_server_socket_pool_t *pool,
+                                   http_socket_t *socket);
+
+/// Posts the multishot receive of a socket to the io_uring.
+int32_t __http_socket_pool__uring_arm_recv(http_server_socket_pool_t *pool,
+                                           http_socket_t *socket);
+
+/// Posts the receive of a socket again after the kernel terminated it, a
+///  throttled socket gets it once it resumes.
+int32_t __http_socket_pool__uring_rearm_recv(http_server_socket_pool_t *pool,
+                                             http_socket_t *socket);
+
+/// Registers a socket from the pool thread, and posts its receive when
+///  using io_uring, closes the socket if this fails.
+void __http_socket_pool__adopt_socket(http_server_socket_pool_t *pool,
+                                      http_socket_t *socket);
+
+/// Registers all the connections the acceptor handed over through the incoming
+///  queue.
+void __http_socket_pool__drain_incoming(http_server_socket_pool_t *pool);
+
+/// Posts the multishot accept of the pool listener to the io_uring.
+int32_t __http_socket_pool__uring_arm_accept(http_server_socket_pool_t *pool);
+
+/// Creates the socket for an accepted connection and registers it, the
+///  connection must already be counted in the load of the pool.
+void __http_socket_pool__register_accepted(http_server_socket_pool_t *pool,
+                                           int32_t fd,
+                                           struct sockaddr_in *address);
+
+/// Accepts the pending connections of the pool listener (epoll engine).
+void __http_socket_pool__on_acceptable(http_server_socket_pool_t *pool);
+
+/// Copies data received by io_uring into the receive buffer and processes
+///  it, what arrives while the socket is throttled is kept aside.
+int32_t __http_socket_pool__uring_receive(http_server_socket_t *sock,
+                                          http_server_socket_pool_t *pool,
+                                          http_socket_t *socket,
+                                          const uint8_t *data, size_t size);
+
+/// Handles an io_uring receive completion.
+int32_t __http_socket_pool__uring_on_recv(http_server_socket_t *sock,
+                                          http_server_socket_pool_t *pool,
+                                          http_socket_t *socket,
+                                          struct io_uring_cqe *cqe);
+
+/// Handles a single io_uring completion.
+void __http_socket_pool__uring_on_cqe(http_server_socket_t *sock,
+                                      http_server_socket_pool_t *pool,
+                                      struct io_uring_cqe *cqe);
+
+/// Gets the load of the pool, the pending write bytes are weighed against
+///  the number of connections.
+size_t __http_server_socket_pool_load(http_server_socket_pool_t *pool);
+
+/// Adds the write bytes the socket queued or wrote since the last call to
+///  the load of the pool.
+void __http_socket_pool__account_writes(http_server_socket_pool_t *pool,
                                         http_socket_t *socket);
 
+/// Event loop for the epoll engine.
+void __http_socket_pool_method__epoll(http_server_socket_t *sock,
+                                      http_server_socket_pool_t *pool);
+
+/// Event loop for the io_uring engine.
+void __http_socket_pool_method__uring(http_server_socket_t *sock,
+                                      http_server_socket_pool_t *pool);
+
+/// Moves the memory of a pinned pool to its own NUMA node, by re-allocating
+///  it from the pool thread itself (first touch).
+void __http_socket_pool__localize(http_server_socket_pool_t *pool);
+
 /// Event loop for HTTP server pool process.
 void *__http_socket_pool_method(void *arg);
 
@@ -303,8 +848,19 @@ int32_t http_server_start_thread_pools(http_server_socket_t *sock);
 // HTTP Server Socket Acceptor
 ///////////////////////////////////////////////////////////////////////////////
 
-/// Accepts an client socket, returns NULL if not possible.
-http_socket_t *__http_server__accept_socket(http_server_socket_t *sock);
+/// Accepts an client connection, returns -1 if not possible.
+int32_t __http_server__accept_socket(http_server_socket_t *sock,
+                                     http_server_socket_pool__incoming_t *conn);
+
+/// Selects the index of the pool a new socket should go to, according to the
+///  placement policy of the server.
+size_t __http_server_acceptor__select_pool(http_server_socket_t *sock,
+                                           const struct sockaddr_in *address);
+
+/// Hands an accepted connection to the selected pool, through its incoming
+///  queue.
+void __http_server_acceptor__register_socket(
+    http_server_socket_t *sock, const http_server_socket_pool__incoming_t *conn);
 
 /// Accepts incomming connections.
 void *__http_server_acceptor(void *arg);
@@ -0,0 +1,69 @@
+/*
+    Copyright 2021 Luke A.C.A. Rieff
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/*
+    HTTP Status Line: The status lines of every known code, for every HTTP
+     version, formatted once at startup. Writing the status line of a
+     response is then a single copy, only codes without a reason phrase
+     still need to be formatted.
+*/
+
+#ifndef _HTTP_STATUS_LINE_H
+#define _HTTP_STATUS_LINE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "http_code.h"
+#include "http_version.h"
+
+/// The range of codes which have a slot in the table.
+#define HTTP_STATUS_LINE_MIN_CODE 100
+#define HTTP_STATUS_LINE_MAX_CODE 599
+
+#define HTTP_STATUS_LINE_CODES                                                 \
+  (HTTP_STATUS_LINE_MAX_CODE - HTTP_STATUS_LINE_MIN_CODE + 1)
+#define HTTP_STATUS_LINE_VERSIONS (HTTP_VERSION_3 + 1)
+
+///////////////////////////////////////////////////////////////////////////////
+// Data Types
+///////////////////////////////////////////////////////////////////////////////
+
+/// A formatted status line, including the terminating CRLF.
+typedef struct {
+  const char *line;
+  size_t len;
+} http_status_line_t;
+
+///////////////////////////////////////////////////////////////////////////////
+// HTTP Status Line
+///////////////////////////////////////////////////////////////////////////////
+
+/// Formats the status lines of all the known codes for every version, the
+///  invalid version gets the lines of HTTP/1.1.
+int32_t http_status_line_init(void);
+
+/// Frees the table of status lines.
+void http_status_line_free(void);
+
+/// Gets the formatted status line of the specified version and code, returns
+///  NULL if the code is not known.
+const http_status_line_t *http_status_line_get(http_version_t version,
+                                               uint32_t code);
+
+#endif
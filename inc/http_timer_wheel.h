@@ -0,0 +1,85 @@
+/*
+    Copyright 2021 Luke A.C.A. Rieff
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/*
+    HTTP Timer Wheel: Hashed timer wheel, timers are hashed into a slot by
+     their deadline, so arming, re-arming and cancelling are O(1), and every
+     tick only looks at the timers of one slot.
+*/
+
+#ifndef _HTTP_TIMER_WHEEL_H
+#define _HTTP_TIMER_WHEEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// Data Types
+///////////////////////////////////////////////////////////////////////////////
+
+struct http_timer {
+  struct http_timer *next;
+  struct http_timer *prev;
+  //---------------------------//
+  int64_t deadline;
+  size_t slot;
+  uint32_t kind;
+  bool armed;
+  void *data;
+};
+typedef struct http_timer http_timer_t;
+
+typedef void (*http_timer_callback_t)(http_timer_t *, void *);
+
+typedef struct {
+  http_timer_t **slots;
+  size_t mask;
+  //---------------------------//
+  int64_t tick;
+  int64_t current;
+} http_timer_wheel_t;
+
+///////////////////////////////////////////////////////////////////////////////
+// HTTP Timer Wheel
+///////////////////////////////////////////////////////////////////////////////
+
+/// Gets the current monotonic time in milliseconds.
+int64_t http_timer_wheel_now(void);
+
+/// Initializes a timer wheel, the slot count must be a power of two and the
+///  tick is the resolution in milliseconds.
+int32_t http_timer_wheel_init(http_timer_wheel_t *wheel, size_t slot_count,
+                              int64_t tick);
+
+/// Frees the slots of a timer wheel, the timers themselves are not owned.
+void http_timer_wheel_free(http_timer_wheel_t *wheel);
+
+/// Arms (or re-arms) a timer to expire the specified milliseconds from now.
+void http_timer_wheel_arm(http_timer_wheel_t *wheel, http_timer_t *timer,
+                          int64_t timeout);
+
+/// Cancels a timer, does nothing if it is not armed.
+void http_timer_wheel_cancel(http_timer_wheel_t *wheel, http_timer_t *timer);
+
+/// Advances the wheel to the current time, and calls the callback for every
+///  timer which expired, the timer is cancelled before the call.
+void http_timer_wheel_advance(http_timer_wheel_t *wheel,
+                              http_timer_callback_t callback, void *arg);
+
+#endif
@@ -0,0 +1,126 @@
+/*
+    Copyright 2021 Luke A.C.A. Rieff
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/*
+    HTTP io_uring: Minimal io_uring wrapper on top of the raw system calls, so
+     we do not depend on liburing being installed.
+*/
+
+#ifndef _HTTP_URING_H
+#define _HTTP_URING_H
+
+#include <errno.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <linux/io_uring.h>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+/// The buffer group ID used for the provided receive buffers.
+#define HTTP_URING_BUFFER_GROUP 0
+
+///////////////////////////////////////////////////////////////////////////////
+// Data Types
+///////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+  int32_t fd;
+  //---------------------------//
+  uint32_t *sq_head;
+  uint32_t *sq_tail;
+  uint32_t sq_mask;
+  uint32_t sq_entries;
+  uint32_t sqe_tail;
+  struct io_uring_sqe *sqes;
+  //---------------------------//
+  uint32_t *cq_head;
+  uint32_t *cq_tail;
+  uint32_t cq_mask;
+  struct io_uring_cqe *cqes;
+  //---------------------------//
+  void *ring;
+  size_t ring_size;
+  size_t sqes_size;
+  //---------------------------//
+  struct io_uring_buf_ring *buf_ring;
+  size_t buf_ring_size;
+  uint8_t *bufs;
+  uint32_t buf_count;
+  uint32_t buf_size;
+} http_uring_t;
+
+///////////////////////////////////////////////////////////////////////////////
+// HTTP io_uring
+///////////////////////////////////////////////////////////////////////////////
+
+/// Initializes an io_uring instance with the specified number of entries.
+int32_t http_uring_init(http_uring_t *ring, uint32_t entries);
+
+/// Frees an io_uring instance, including the provided buffers.
+void http_uring_free(http_uring_t *ring);
+
+/// Registers a ring of provided buffers, used by multishot receives.
+int32_t http_uring_setup_buffers(http_uring_t *ring, uint32_t count,
+                                 uint32_t size);
+
+/// Gets the provided buffer with the specified ID.
+uint8_t *http_uring_get_buffer(http_uring_t *ring, uint16_t bid);
+
+/// Gives the provided buffer back to the kernel.
+void http_uring_recycle_buffer(http_uring_t *ring, uint16_t bid);
+
+/// Submits the pending entries, and optionally waits for completions.
+int32_t __http_uring_enter(http_uring_t *ring, uint32_t wait_nr,
+                           uint32_t timeout);
+
+/// Gets an empty submission queue entry, submits if the queue is full.
+struct io_uring_sqe *http_uring_get_sqe(http_uring_t *ring);
+
+/// Submits all the pending submission queue entries, and waits for at least
+///  one completion or the timeout (in milliseconds) to expire.
+int32_t http_uring_submit_and_wait(http_uring_t *ring, uint32_t timeout);
+
+/// Gets the next completion queue entry, or NULL if there is none.
+struct io_uring_cqe *http_uring_peek_cqe(http_uring_t *ring);
+
+/// Marks the current completion queue entry as seen.
+void http_uring_cqe_seen(http_uring_t *ring);
+
+///////////////////////////////////////////////////////////////////////////////
+// HTTP io_uring Preparation
+///////////////////////////////////////////////////////////////////////////////
+
+/// Prepares a multishot receive, which uses the provided buffers.
+void http_uring_prep_recv_multishot(struct io_uring_sqe *sqe, int32_t fd,
+                                    uint64_t user_data);
+
+/// Prepares a (possibly multishot) poll.
+void http_uring_prep_poll(struct io_uring_sqe *sqe, int32_t fd,
+                          uint32_t events, bool multishot,
+                          uint64_t user_data);
+
+/// Prepares the cancellation of the request with the target user data.
+void http_uring_prep_cancel(struct io_uring_sqe *sqe, uint64_t target,
+                            uint64_t user_data);
+
+#endif
@@ -17,20 +17,21 @@
 #ifndef _HTTP_URL_H
 #define _HTTP_URL_H
 
+#include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
-#include <regex.h>
+
+#include "http_common.h"
 
 typedef struct {
-    char           *path;
-    char           *search;
+    http_slice_t    path;
+    http_slice_t    query;
 } http_url_t;
 
-/// Parses an URL.
-int32_t http_url_parse (http_url_t *url, const char *raw);
-
-/// Frees an URL.
-void http_url_free (http_url_t *url);
+/// Splits the target of a request into its path and query, which are slices
+///  of the same buffer. The query does not include the question mark, and is
+///  empty when there are no search parameters.
+int32_t http_url_parse (http_url_t *url, const uint8_t *buffer, http_slice_t target);
 
 #endif
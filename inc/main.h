@@ -30,6 +30,18 @@
 #include "http_url.h"
 #include "router/http_router.h"
 
+typedef struct {
+    http_server_socket_pool_engine_t engine;
+    bool pool_listeners;
+    http_server_socket_placement_t placement;
+    size_t pool_count;
+    bool pin_pools;
+    bool zerocopy;
+} main_args_t;
+
+/// Parses a single command line option.
+error_t __main_parse_opt (int key, char *arg, struct argp_state *state);
+
 int main (int argc, char **argv);
 
 #endif
@@ -34,7 +34,7 @@ typedef enum {
 } http_route_type_t;
 
 typedef enum {
-  HTTP_ROUTE_FLAG__MATCH_ALL = 0,
+  HTTP_ROUTE_FLAG__MATCH_ALL = (1 << 0),
 } http_route_flag_t;
 
 struct http_route {
@@ -42,6 +42,7 @@ struct http_route {
   void *data;
   void *u;
   const char *path;
+  size_t path_len;
   struct http_route *next;
   uint32_t flags;
 };
@@ -52,8 +53,11 @@ typedef struct {
   http_route_t *entry;
 } http_router_t;
 
+/// The callback of a route, it gets the rest of the path after the route,
+///  which is not terminated, or NULL if there is none.
 typedef void (*http_route_callback)(http_socket_t *, const http_request_t *,
-                                    http_response_t *, const char *, void *u);
+                                    http_response_t *, const char *, size_t,
+                                    void *u);
 
 /// Registers an callback route.
 int32_t http_router__register_callback(http_router_t *router, const char *path,
@@ -63,9 +67,16 @@ int32_t http_router__register_callback(http_router_t *router, const char *path,
 http_router_t *http_router__register_subroute(http_router_t *router,
                                               const char *path);
 
-/// Uses an HTTP router.
+/// Gets the next part of the path, which starts at offset, the slashes
+///  before it are skipped. Returns NULL if there are no parts left.
+const char *__http_router_next_part(const char *path, size_t path_len,
+                                    size_t *offset, size_t *part_len);
+
+/// Uses an HTTP router, the path does not have to be terminated, the parts
+///  of it are matched in place.
 int32_t http_router_use(http_router_t *router, http_socket_t *socket,
                         const http_request_t *request,
-                        http_response_t *response, const char *path);
+                        http_response_t *response, const char *path,
+                        size_t path_len);
 
 #endif
@@ -0,0 +1,106 @@
+/*
+    Copyright 2021 Luke A.C.A. Rieff
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "http_buffer_pool.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// HTTP Buffer Pool
+///////////////////////////////////////////////////////////////////////////////
+
+/// Gets the index of the smallest class which holds the specified size, or
+///  -1 if it's larger than the largest class.
+int32_t __http_buffer_pool_class(size_t size) {
+  size_t class_size = HTTP_BUFFER_POOL_MIN_SIZE;
+
+  for (int32_t i = 0; i < HTTP_BUFFER_POOL_CLASS_COUNT; ++i) {
+    if (size <= class_size)
+      return i;
+
+    class_size <<= 2;
+  }
+
+  return -1;
+}
+
+/// Initializes a buffer pool.
+void http_buffer_pool_init(http_buffer_pool_t *pool) {
+  for (int32_t i = 0; i < HTTP_BUFFER_POOL_CLASS_COUNT; ++i) {
+    pool->free[i] = NULL;
+    pool->free_count[i] = 0;
+  }
+}
+
+/// Frees all the cached buffers of a buffer pool.
+void http_buffer_pool_free(http_buffer_pool_t *pool) {
+  for (int32_t i = 0; i < HTTP_BUFFER_POOL_CLASS_COUNT; ++i) {
+    while (pool->free[i] != NULL) {
+      http_buffer_pool__free_t *next = pool->free[i]->next;
+      free(pool->free[i]);
+      pool->free[i] = next;
+    }
+
+    pool->free_count[i] = 0;
+  }
+}
+
+/// Gets the size of the smallest class which holds the specified size, or
+///  zero if it's larger than the largest class.
+size_t http_buffer_pool_class_size(size_t size) {
+  int32_t i = __http_buffer_pool_class(size);
+  if (i < 0)
+    return 0;
+
+  return (size_t)HTTP_BUFFER_POOL_MIN_SIZE << (2 * i);
+}
+
+/// Gets a buffer of at least the specified size, its actual size is stored
+///  in size_out. Returns NULL if the size is too large, or allocation fails.
+uint8_t *http_buffer_pool_get(http_buffer_pool_t *pool, size_t size,
+                              size_t *size_out) {
+  int32_t i = __http_buffer_pool_class(size);
+  if (i < 0)
+    return NULL;
+
+  *size_out = (size_t)HTTP_BUFFER_POOL_MIN_SIZE << (2 * i);
+
+  // Takes a cached buffer if there is one, otherwise allocate a new one.
+  //  Every buffer is allocated on its own, so it may also just be freed.
+  if (pool->free[i] != NULL) {
+    http_buffer_pool__free_t *buffer = pool->free[i];
+    pool->free[i] = buffer->next;
+    --pool->free_count[i];
+
+    return (uint8_t *)buffer;
+  }
+
+  return (uint8_t *)malloc(*size_out);
+}
+
+/// Gives a buffer of the specified (class) size back to the pool.
+void http_buffer_pool_put(http_buffer_pool_t *pool, uint8_t *buffer,
+                          size_t size) {
+  int32_t i = __http_buffer_pool_class(size);
+
+  if (i < 0 || pool->free_count[i] >= HTTP_BUFFER_POOL_MAX_CACHED) {
+    free(buffer);
+    return;
+  }
+
+  http_buffer_pool__free_t *entry = (http_buffer_pool__free_t *)buffer;
+  entry->next = pool->free[i];
+  pool->free[i] = entry;
+  ++pool->free_count[i];
+}
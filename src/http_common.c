@@ -37,7 +37,49 @@ bool strcicmp (const char *a, const char *b) {
     }
 }
 
+/// Compares the first len bytes of a, which does not have to be terminated,
+///  with the string b case insensitive.
+bool strncicmp (const char *a, size_t len, const char *b) {
+    for (size_t i = 0; i < len; ++i) {
+        if (b[i] == '\0' || tolower ((unsigned char) a[i]) != tolower ((unsigned char) b[i]))
+            return false;
+    }
+
+    return b[len] == '\0';
+}
+
 /// Gets the extension from an file.
 const char *path_get_ext (const char *path) {
     return strrchr (path, '.');
 }
+
+/// Writes the decimal representation of value to buffer (which must hold at
+///  least 21 bytes), and returns the number of digits.
+size_t u64_to_string (char *buffer, uint64_t value) {
+    char digits[20];
+    size_t n = 0;
+
+    // Produces the digits in reverse order, and copies them back in order.
+    do {
+        digits[n++] = (char) ('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+
+    for (size_t i = 0; i < n; ++i)
+        buffer[i] = digits[n - i - 1];
+    buffer[n] = '\0';
+
+    return n;
+}
+
+/// Hashes an string (FNV-1a), used as key by the caches.
+uint64_t string_hash (const char *str) {
+    uint64_t hash = 14695981039346656037ULL;
+
+    for (const uint8_t *p = (const uint8_t *) str; *p != '\0'; ++p) {
+        hash ^= *p;
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
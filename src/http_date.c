@@ -0,0 +1,99 @@
+/*
+    Copyright 2021 Luke A.C.A. Rieff
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "http_date.h"
+
+const char *g_HttpDateDays[] = {"Sun", "Mon", "Tue", "Wed",
+                                "Thu", "Fri", "Sat"};
+const char *g_HttpDateMonths[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                  "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+char g_HttpDateSlots[HTTP_DATE_SLOTS][HTTP_DATE_SIZE + 1];
+const char *g_HttpDate = NULL;
+int64_t g_HttpDateSecond = -1;
+
+///////////////////////////////////////////////////////////////////////////////
+// HTTP Date
+///////////////////////////////////////////////////////////////////////////////
+
+/// Formats the specified time as IMF-fixdate into buffer, which must hold
+///  HTTP_DATE_SIZE bytes plus the terminating zero.
+void http_date_format(char *buffer, time_t t) {
+  struct tm tm;
+  gmtime_r(&t, &tm);
+
+  // Writes the fixed-width fields by hand, strftime () would depend on the
+  //  locale for the names.
+  memcpy(&buffer[0], g_HttpDateDays[tm.tm_wday], 3);
+  buffer[3] = ',';
+  buffer[4] = ' ';
+  buffer[5] = (char)('0' + tm.tm_mday / 10);
+  buffer[6] = (char)('0' + tm.tm_mday % 10);
+  buffer[7] = ' ';
+  memcpy(&buffer[8], g_HttpDateMonths[tm.tm_mon], 3);
+  buffer[11] = ' ';
+
+  int32_t year = tm.tm_year + 1900;
+  buffer[12] = (char)('0' + year / 1000 % 10);
+  buffer[13] = (char)('0' + year / 100 % 10);
+  buffer[14] = (char)('0' + year / 10 % 10);
+  buffer[15] = (char)('0' + year % 10);
+  buffer[16] = ' ';
+  buffer[17] = (char)('0' + tm.tm_hour / 10);
+  buffer[18] = (char)('0' + tm.tm_hour % 10);
+  buffer[19] = ':';
+  buffer[20] = (char)('0' + tm.tm_min / 10);
+  buffer[21] = (char)('0' + tm.tm_min % 10);
+  buffer[22] = ':';
+  buffer[23] = (char)('0' + tm.tm_sec / 10);
+  buffer[24] = (char)('0' + tm.tm_sec % 10);
+  memcpy(&buffer[25], " GMT", 4);
+  buffer[HTTP_DATE_SIZE] = '\0';
+}
+
+/// Formats the date again if the second changed since the last time, only
+///  one of the pools calling this at the same time does the work.
+void http_date_update(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+
+  int64_t second = (int64_t)ts.tv_sec;
+  int64_t last = __atomic_load_n(&g_HttpDateSecond, __ATOMIC_RELAXED);
+  if (second == last ||
+      !__atomic_compare_exchange_n(&g_HttpDateSecond, &last, second, false,
+                                   __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+    return;
+
+  // Formats into the next slot, which nobody reads anymore, and publishes it.
+  char *slot = g_HttpDateSlots[(uint64_t)second % HTTP_DATE_SLOTS];
+  http_date_format(slot, (time_t)second);
+
+  __atomic_store_n(&g_HttpDate, slot, __ATOMIC_RELEASE);
+}
+
+/// Gets the current date, HTTP_DATE_SIZE bytes long.
+const char *http_date_get(void) {
+  const char *date = __atomic_load_n(&g_HttpDate, __ATOMIC_ACQUIRE);
+
+  // Only before the first update, formats it right away, or waits for the
+  //  pool which is already doing so.
+  while (date == NULL) {
+    http_date_update();
+    date = __atomic_load_n(&g_HttpDate, __ATOMIC_ACQUIRE);
+  }
+
+  return date;
+}
@@ -0,0 +1,347 @@
+/*
+    Copyright 2021 Luke A.C.A. Rieff
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "http_file_cache.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// HTTP File Cache Entry
+///////////////////////////////////////////////////////////////////////////////
+
+/// Opens the file at the specified path and creates an entry for it, with
+///  a single reference. Returns NULL if it's not a regular file.
+http_file_cache_entry_t *__http_file_cache_entry_open(const char *path,
+                                                      uint64_t hash) {
+  int32_t fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    if (errno != ENOENT)
+      perror("open () error");
+    return NULL;
+  }
+
+  // Only regular files are served.
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    perror("fstat () failed");
+    close(fd);
+    return NULL;
+  } else if (!S_ISREG(st.st_mode)) {
+    close(fd);
+    return NULL;
+  }
+
+  http_file_cache_entry_t *entry =
+      (http_file_cache_entry_t *)calloc(1, sizeof(http_file_cache_entry_t));
+  if (entry == NULL) {
+    close(fd);
+    return NULL;
+  }
+
+  entry->path = strdup(path);
+  if (entry->path == NULL) {
+    free(entry);
+    close(fd);
+    return NULL;
+  }
+
+  entry->hash = hash;
+  entry->refs = 1;
+  entry->fd = fd;
+  entry->dev = st.st_dev;
+  entry->ino = st.st_ino;
+  entry->size = st.st_size;
+  entry->mtime = st.st_mtim;
+
+  // Resolves the content type once, instead of for every request.
+  entry->type = http_content_type_from_ext(path_get_ext(path));
+  if (entry->type == HTTP_CONTENT_TYPE_UNKNOWN)
+    entry->type = HTTP_CONTENT_TYPE_APPLICATION_OCTET_STREAM;
+
+  if (__http_file_cache_entry_render(entry) != 0) {
+    http_file_cache_entry_release(entry);
+    return NULL;
+  }
+
+  return entry;
+}
+
+/// Renders the headers which describe the file of the entry, in the same
+///  format they're written to the socket.
+int32_t __http_file_cache_entry_render(http_file_cache_entry_t *entry) {
+  const char *type = http_content_type_to_string(entry->type);
+  if (type == NULL)
+    return -1;
+
+  char size[21];
+  u64_to_string(size, (uint64_t)entry->size);
+
+  const char *format =
+      "Content-Type: %s\r\nContent-Length: %s\r\nAccept-Ranges: %s\r\n";
+  const char *range = http_accept_range_to_string(HTTP_ACCEPT_RANGE_BYTES);
+
+  int32_t len = snprintf(NULL, 0, format, type, size, range);
+  if (len < 0)
+    return -1;
+
+  entry->headers = (char *)malloc((size_t)len + 1);
+  if (entry->headers == NULL)
+    return -1;
+
+  snprintf(entry->headers, (size_t)len + 1, format, type, size, range);
+  entry->headers_len = (size_t)len;
+
+  return 0;
+}
+
+/// Checks if the entry still describes the file with the specified stat.
+bool __http_file_cache_entry_matches(http_file_cache_entry_t *entry,
+                                     const struct stat *st) {
+  return entry->dev == st->st_dev && entry->ino == st->st_ino &&
+         entry->size == st->st_size &&
+         entry->mtime.tv_sec == st->st_mtim.tv_sec &&
+         entry->mtime.tv_nsec == st->st_mtim.tv_nsec;
+}
+
+/// Takes an extra reference to an entry.
+void http_file_cache_entry_retain(http_file_cache_entry_t *entry) {
+  __atomic_add_fetch(&entry->refs, 1, __ATOMIC_RELAXED);
+}
+
+/// Drops a reference to an entry, the last one closes the file.
+void http_file_cache_entry_release(http_file_cache_entry_t *entry) {
+  if (__atomic_sub_fetch(&entry->refs, 1, __ATOMIC_ACQ_REL) != 0)
+    return;
+
+  if (close(entry->fd) != 0)
+    perror("close () failed");
+
+  free(entry->headers);
+  free(entry->path);
+  free(entry);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// HTTP File Cache
+///////////////////////////////////////////////////////////////////////////////
+
+/// Finds the entry of the specified path inside a locked shard.
+http_file_cache_entry_t *__http_file_cache_find(http_file_cache_shard_t *shard,
+                                                uint64_t hash,
+                                                const char *path) {
+  // The low bits of the hash select the shard, so use the next ones for the
+  //  bucket.
+  http_file_cache_entry_t *entry =
+      shard->buckets[(hash / HTTP_FILE_CACHE_SHARDS) &
+                     (HTTP_FILE_CACHE_BUCKETS - 1)];
+
+  for (; entry != NULL; entry = entry->next) {
+    if (entry->hash == hash && strcmp(entry->path, path) == 0)
+      return entry;
+  }
+
+  return NULL;
+}
+
+/// Moves an entry to the front of the usage list of its locked shard.
+void __http_file_cache_touch(http_file_cache_shard_t *shard,
+                             http_file_cache_entry_t *entry) {
+  if (shard->lru_start == entry)
+    return;
+
+  // Takes the entry out of the list.
+  entry->lru_prev->lru_next = entry->lru_next;
+  if (entry->lru_next != NULL)
+    entry->lru_next->lru_prev = entry->lru_prev;
+  else
+    shard->lru_end = entry->lru_prev;
+
+  // Puts it back at the start.
+  entry->lru_prev = NULL;
+  entry->lru_next = shard->lru_start;
+  shard->lru_start->lru_prev = entry;
+  shard->lru_start = entry;
+}
+
+/// Removes an entry from its locked shard, the reference of the cache is
+///  handed to the caller, which should release it after unlocking.
+void __http_file_cache_unlink(http_file_cache_shard_t *shard,
+                              http_file_cache_entry_t *entry) {
+  http_file_cache_entry_t **p =
+      &shard->buckets[(entry->hash / HTTP_FILE_CACHE_SHARDS) &
+                      (HTTP_FILE_CACHE_BUCKETS - 1)];
+  while (*p != entry)
+    p = &(*p)->next;
+  *p = entry->next;
+
+  if (entry->lru_prev != NULL)
+    entry->lru_prev->lru_next = entry->lru_next;
+  else
+    shard->lru_start = entry->lru_next;
+
+  if (entry->lru_next != NULL)
+    entry->lru_next->lru_prev = entry->lru_prev;
+  else
+    shard->lru_end = entry->lru_prev;
+
+  entry->cached = false;
+  --shard->count;
+}
+
+/// Inserts an entry into its locked shard, if the shard is full the least
+///  recently used entry is unlinked and returned, otherwise NULL.
+http_file_cache_entry_t *
+__http_file_cache_insert(http_file_cache_shard_t *shard,
+                         http_file_cache_entry_t *entry) {
+  http_file_cache_entry_t *evicted = NULL;
+
+  if (shard->count == HTTP_FILE_CACHE_SHARD_SIZE) {
+    evicted = shard->lru_end;
+    __http_file_cache_unlink(shard, evicted);
+  }
+
+  // The cache holds a reference of its own.
+  http_file_cache_entry_retain(entry);
+  entry->cached = true;
+
+  http_file_cache_entry_t **bucket =
+      &shard->buckets[(entry->hash / HTTP_FILE_CACHE_SHARDS) &
+                      (HTTP_FILE_CACHE_BUCKETS - 1)];
+  entry->next = *bucket;
+  *bucket = entry;
+
+  entry->lru_prev = NULL;
+  entry->lru_next = shard->lru_start;
+  if (shard->lru_start != NULL)
+    shard->lru_start->lru_prev = entry;
+  else
+    shard->lru_end = entry;
+  shard->lru_start = entry;
+
+  ++shard->count;
+
+  return evicted;
+}
+
+/// Initializes a file cache.
+int32_t http_file_cache_init(http_file_cache_t *cache) {
+  memset(cache, 0, sizeof(http_file_cache_t));
+
+  for (size_t i = 0; i < HTTP_FILE_CACHE_SHARDS; ++i) {
+    if (pthread_mutex_init(&cache->shards[i].mutex, NULL) != 0) {
+      perror("pthread_mutex_init () failed");
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+/// Frees a file cache, the entries which are still referenced stay open
+///  until they're released.
+void http_file_cache_free(http_file_cache_t *cache) {
+  for (size_t i = 0; i < HTTP_FILE_CACHE_SHARDS; ++i) {
+    http_file_cache_shard_t *shard = &cache->shards[i];
+
+    while (shard->lru_start != NULL) {
+      http_file_cache_entry_t *entry = shard->lru_start;
+      __http_file_cache_unlink(shard, entry);
+      http_file_cache_entry_release(entry);
+    }
+
+    pthread_mutex_destroy(&shard->mutex);
+  }
+}
+
+/// Gets the entry of the file at the specified path, opening it if it's not
+///  cached or has changed. The caller must release the returned entry,
+///  returns NULL if the file can not be served.
+http_file_cache_entry_t *http_file_cache_get(http_file_cache_t *cache,
+                                             const char *path) {
+  uint64_t hash = string_hash(path);
+  http_file_cache_shard_t *shard =
+      &cache->shards[hash & (HTTP_FILE_CACHE_SHARDS - 1)];
+  int64_t now = http_timer_wheel_now();
+
+  // Looks the file up, a hit within its time to live needs no system calls.
+  pthread_mutex_lock(&shard->mutex);
+
+  http_file_cache_entry_t *entry = __http_file_cache_find(shard, hash, path);
+  bool fresh = false;
+  if (entry != NULL) {
+    http_file_cache_entry_retain(entry);
+    __http_file_cache_touch(shard, entry);
+    fresh = entry->expires > now;
+  }
+
+  pthread_mutex_unlock(&shard->mutex);
+
+  if (fresh)
+    return entry;
+
+  // The entry expired, if the file did not change it's trusted for another
+  //  period, otherwise it is replaced.
+  if (entry != NULL) {
+    struct stat st;
+    bool unchanged =
+        stat(path, &st) == 0 && __http_file_cache_entry_matches(entry, &st);
+
+    pthread_mutex_lock(&shard->mutex);
+
+    if (unchanged) {
+      entry->expires = now + HTTP_FILE_CACHE_TTL;
+      pthread_mutex_unlock(&shard->mutex);
+      return entry;
+    }
+
+    http_file_cache_entry_t *stale = entry->cached ? entry : NULL;
+    if (stale != NULL)
+      __http_file_cache_unlink(shard, stale);
+
+    pthread_mutex_unlock(&shard->mutex);
+
+    if (stale != NULL)
+      http_file_cache_entry_release(stale);
+    http_file_cache_entry_release(entry);
+  }
+
+  // Opens the file without holding the lock.
+  entry = __http_file_cache_entry_open(path, hash);
+  if (entry == NULL)
+    return NULL;
+
+  entry->expires = now + HTTP_FILE_CACHE_TTL;
+
+  pthread_mutex_lock(&shard->mutex);
+
+  // Another pool may have opened the same file meanwhile, use theirs.
+  http_file_cache_entry_t *existing = __http_file_cache_find(shard, hash, path);
+  http_file_cache_entry_t *evicted = NULL;
+  if (existing != NULL)
+    http_file_cache_entry_retain(existing);
+  else
+    evicted = __http_file_cache_insert(shard, entry);
+
+  pthread_mutex_unlock(&shard->mutex);
+
+  if (evicted != NULL)
+    http_file_cache_entry_release(evicted);
+
+  if (existing != NULL) {
+    http_file_cache_entry_release(entry);
+    return existing;
+  }
+
+  return entry;
+}
@@ -28,25 +28,61 @@ http_headers_t *http_headers_new(void) {
 
   headers->end = headers->start = NULL;
   headers->count = 0;
+  headers->unused = NULL;
+  headers->n_unused = 0;
 
   return headers;
 }
 
-/// Copies an HTTP header, and stores the pointer in p.
-int32_t __http_headers_insert_copy_val(const char **p) {
-  const char *temp;
-  size_t len;
+/// Takes an header from the unused list, or allocates a new one.
+http_header_t *__http_headers_take_header(http_headers_t *headers) {
+  http_header_t *header = headers->unused;
+  if (header != NULL) {
+    headers->unused = header->next;
+    --headers->n_unused;
+    return header;
+  }
+
+  header = (http_header_t *)malloc(sizeof(http_header_t));
+  if (header == NULL)
+    return NULL;
+
+  header->storage = NULL;
+  header->storage_size = 0;
+
+  return header;
+}
+
+/// Puts an header on the unused list, its storage is kept for the next one,
+///  once the list holds HTTP_HEADERS_MAX_UNUSED headers it is freed instead.
+void __http_headers_put_header(http_headers_t *headers, http_header_t *header) {
+  if (headers->n_unused >= HTTP_HEADERS_MAX_UNUSED) {
+    __http_header_free(&header);
+    return;
+  }
+
+  if (header->flags & HTTP_HEADER_FLAG_FREE_KEY)
+    free((void *)header->key);
+  if (header->flags & HTTP_HEADER_FLAG_FREE_VALUE)
+    free((void *)header->value);
+
+  header->flags = 0;
+  header->next = headers->unused;
+  headers->unused = header;
+  ++headers->n_unused;
+}
+
+/// Makes sure the storage of an header can hold at least size bytes.
+int32_t __http_header_reserve_storage(http_header_t *header, size_t size) {
+  if (header->storage_size >= size)
+    return 0;
 
-  // Gets the length of the original value, and allocates the required memory.
-  len = strlen(*p) + 1;
-  temp = (const char *)malloc(len);
-  if (temp == NULL)
+  char *storage = (char *)realloc(header->storage, size);
+  if (storage == NULL)
     return -1;
 
-  // Copy the original data into the new memory, and replace
-  //  the original pointer.
-  memcpy((void *)temp, (void *)*p, len);
-  *p = temp;
+  header->storage = storage;
+  header->storage_size = size;
 
   return 0;
 }
@@ -160,28 +196,33 @@ http_header_t *__http_headers_walk_next(http_headers_walk_ctx_t *ctx) {
 /// Insert header to HTTP headers structure.
 int32_t http_headers_insert(http_headers_t *headers, const char *key,
                             const char *value, uint32_t flags) {
-  // Allocates the new HTTP header.
-  http_header_t *header = malloc(sizeof(http_header_t));
+  // Gets an header, possibly one from a previous request.
+  http_header_t *header = __http_headers_take_header(headers);
   if (header == NULL)
     return -1;
 
   header->flags = 0;
 
-  // Copies the memory if required.
-  if (flags & HTTP_HEADER_INSERT_FLAG_COPY_KEY) {
-    header->flags |= HTTP_HEADER_FLAG_FREE_KEY;
-    if (__http_headers_insert_copy_val(&key) == -1) {
-      free(header);
-      return -1;
-    }
+  // Copies the key and value into the storage of the header if required,
+  //  the storage only grows, so reused headers rarely allocate.
+  size_t key_size =
+      (flags & HTTP_HEADER_INSERT_FLAG_COPY_KEY) ? strlen(key) + 1 : 0;
+  size_t value_size =
+      (flags & HTTP_HEADER_INSERT_FLAG_COPY_VALUE) ? strlen(value) + 1 : 0;
+
+  if (__http_header_reserve_storage(header, key_size + value_size) != 0) {
+    __http_headers_put_header(headers, header);
+    return -1;
   }
 
-  if (flags & HTTP_HEADER_INSERT_FLAG_COPY_VALUE) {
-    header->flags |= HTTP_HEADER_FLAG_FREE_VALUE;
-    if (__http_headers_insert_copy_val(&value) == -1) {
-      free(header);
-      return -1;
-    }
+  if (key_size != 0) {
+    memcpy(header->storage, key, key_size);
+    key = header->storage;
+  }
+
+  if (value_size != 0) {
+    memcpy(&header->storage[key_size], value, value_size);
+    value = &header->storage[key_size];
   }
 
   // Assigns the key and value.
@@ -195,7 +236,7 @@ int32_t http_headers_insert(http_headers_t *headers, const char *key,
     __http_header_insert_start(headers, header);
   else if (flags & HTTP_HEADER_INSERT_FLAG_REPLACE) {
     // TODO: Support this feature.
-    free(header);
+    __http_headers_put_header(headers, header);
     return -1;
   }
 
@@ -209,6 +250,7 @@ void __http_header_free(http_header_t **header) {
   if ((*header)->flags & HTTP_HEADER_FLAG_FREE_VALUE)
     free((void *)(*header)->value);
 
+  free((*header)->storage);
   free(*header);
   *header = NULL;
 }
@@ -232,6 +274,12 @@ int32_t http_headers_free(http_headers_t **headers) {
   // Frees the header walk context.
   http_header_walk_ctx_free(&ctx);
 
+  // Frees the headers which were kept for reuse.
+  while ((header = (*headers)->unused) != NULL) {
+    (*headers)->unused = header->next;
+    __http_header_free(&header);
+  }
+
   // Frees the headers structure.
   free(*headers);
   *headers = NULL;
@@ -239,6 +287,21 @@ int32_t http_headers_free(http_headers_t **headers) {
   return 0;
 }
 
+/// Removes all the headers inside the structure, but keeps the structure
+///  and the headers themselves for reuse.
+void http_headers_clear(http_headers_t *headers) {
+  // Walks the list directly, so no walk context has to be allocated.
+  http_header_t *header = headers->start;
+  while (header != NULL) {
+    http_header_t *next = header->next;
+    __http_headers_put_header(headers, header);
+    header = next;
+  }
+
+  headers->end = headers->start = NULL;
+  headers->count = 0;
+}
+
 /// Adds all headers from structure to another one.
 int32_t http_headers_add_all(http_headers_t *target, http_headers_t *from) {
   // Creates the header walk context.
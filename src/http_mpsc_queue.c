@@ -0,0 +1,119 @@
+/*
+    Copyright 2021 Luke A.C.A. Rieff
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "http_mpsc_queue.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// HTTP MPSC Queue
+///////////////////////////////////////////////////////////////////////////////
+
+/// Initializes an MPSC queue of items of the specified size, the number of
+///  cells must be a power of two.
+int32_t http_mpsc_queue_init(http_mpsc_queue_t *queue, size_t size,
+                             size_t item_size) {
+  if (size == 0 || (size & (size - 1)) != 0) {
+    fprintf(stderr, "MPSC queue size must be a power of two.\r\n");
+    return -1;
+  }
+
+  // Every cell holds the sequence followed by the item, rounded up so the
+  //  sequence of the next cell stays aligned.
+  queue->item_size = item_size;
+  queue->cell_size = (sizeof(http_mpsc_queue__cell_t) + item_size +
+                      sizeof(size_t) - 1) &
+                     ~(sizeof(size_t) - 1);
+
+  queue->cells = (uint8_t *)calloc(size, queue->cell_size);
+  if (queue->cells == NULL)
+    return -2;
+
+  queue->mask = size - 1;
+  queue->enqueue_pos = 0;
+  queue->dequeue_pos = 0;
+
+  // Every cell starts with its own index as sequence, meaning it's free for
+  //  the producer which claims that position.
+  for (size_t i = 0; i < size; ++i)
+    __http_mpsc_queue_cell(queue, i)->sequence = i;
+
+  return 0;
+}
+
+/// Frees the cells of an MPSC queue.
+void http_mpsc_queue_free(http_mpsc_queue_t *queue) {
+  free(queue->cells);
+  queue->cells = NULL;
+}
+
+/// Gets the cell at the specified position.
+http_mpsc_queue__cell_t *__http_mpsc_queue_cell(http_mpsc_queue_t *queue,
+                                                size_t pos) {
+  return (http_mpsc_queue__cell_t *)&queue
+      ->cells[(pos & queue->mask) * queue->cell_size];
+}
+
+/// Copies an item into the queue, returns false if the queue is full. May be
+///  called by any thread.
+bool http_mpsc_queue_push(http_mpsc_queue_t *queue, const void *item) {
+  http_mpsc_queue__cell_t *cell;
+  size_t pos = __atomic_load_n(&queue->enqueue_pos, __ATOMIC_RELAXED);
+
+  for (;;) {
+    cell = __http_mpsc_queue_cell(queue, pos);
+
+    size_t sequence = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+    intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+
+    // If the cell is free for this position, try to claim the position, if
+    //  another producer beat us to it, pos gets updated and we try again.
+    if (diff == 0) {
+      if (__atomic_compare_exchange_n(&queue->enqueue_pos, &pos, pos + 1, true,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        break;
+    } else if (diff < 0) {
+      // The consumer did not yet free the cell, so the queue is full.
+      return false;
+    } else {
+      pos = __atomic_load_n(&queue->enqueue_pos, __ATOMIC_RELAXED);
+    }
+  }
+
+  // Stores the item, and publishes the cell to the consumer.
+  memcpy(&cell[1], item, queue->item_size);
+  __atomic_store_n(&cell->sequence, pos + 1, __ATOMIC_RELEASE);
+
+  return true;
+}
+
+/// Copies the next item out of the queue, returns false if the queue is
+///  empty. May only be called by the consumer thread.
+bool http_mpsc_queue_pop(http_mpsc_queue_t *queue, void *item) {
+  size_t pos = queue->dequeue_pos;
+  http_mpsc_queue__cell_t *cell = __http_mpsc_queue_cell(queue, pos);
+
+  // Checks if the producer already published the cell.
+  size_t sequence = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+  if (sequence != pos + 1)
+    return false;
+
+  memcpy(item, &cell[1], queue->item_size);
+
+  // Frees the cell for the producer which will wrap around to it.
+  __atomic_store_n(&cell->sequence, pos + queue->mask + 1, __ATOMIC_RELEASE);
+  queue->dequeue_pos = pos + 1;
+
+  return true;
+}
@@ -29,14 +29,6 @@ http_request_t *http_request_create (void) {
         free (res);
         return NULL;
     }
-    
-    // Allocates the new headers.
-    res->headers = http_headers_new ();
-    if (res->headers == NULL) {
-        http_segmented_buffer_free (&res->body);
-        free (res);
-        return NULL;
-    }
 
     res->state = HTTP_REQUEST_STATE_RECEIVING_TYPE;
 
@@ -45,70 +37,113 @@ http_request_t *http_request_create (void) {
 
 /// Frees an HTTP request.
 int32_t http_request_free (http_request_t **req) {
-    if (http_headers_free (&((*req)->headers)) != 0)
-        return -1;
-
     // Frees the segmented buffer.
     http_segmented_buffer_free (&(req[0]->body));
 
-    // Frees the url.
-    http_url_free (&(req[0]->parsed_url));
-
-    // Frees the URL.
-    if ((*req)->url != NULL)
-        free ((*req)->url);
-
-
     free (*req);
     *req = NULL;
     
     return 0;
 }
 
-/// Prints HTTP request info.
-void __http_request_print__header_method (const char *str, void *u) {
-    printf ("\t%s", str);
+/// Resets an HTTP request so it can receive the next request, the body
+/// segments are kept, so the next request on the connection can reuse their
+/// memory.
+void http_request_reset (http_request_t *request) {
+    // Clears the body, but keeps its memory.
+    http_segmented_buffer_clear (request->body);
+
+    // Forgets the head, the slices referred to the previous one.
+    request->buffer = NULL;
+    request->head_len = 0;
+    request->header_count = 0;
+
+    // Sets the values back to the ones of a newly created request.
+    request->state = HTTP_REQUEST_STATE_RECEIVING_TYPE;
+    request->flags = 0;
+    request->method = HTTP_METHOD_INVALID;
+    request->version = HTTP_VERSION_INVALID;
+    request->content_type = HTTP_CONTENT_TYPE_UNKNOWN;
+    request->received_body_size = 0;
+    request->expected_body_size = 0;
 }
 
+/// Prints HTTP request info.
 void http_request_print (http_request_t *request) {
     printf ("HTTP request:\r\n");
     printf ("- Method: %s\r\n", http_method_to_string (request->method));
-    printf ("- URL: %s\r\n", request->url);
+    printf ("- URL: %.*s\r\n", (int) request->target.len, http_request_slice (request, request->target));
     printf ("- Version: %s\r\n", http_version_to_string (request->version));
     printf ("- Content Type: %s\r\n", http_content_type_to_string (request->content_type));
     printf ("- Content Length: %lu\r\n", request->expected_body_size);
     printf ("- Body (%lu)\r\n", request->body->segment_count);
     printf ("- Headers:\r\n");
-    http_headers_to_string_no_collapse (request->headers, __http_request_print__header_method, NULL);
+
+    for (uint32_t i = 0; i < request->header_count; ++i) {
+        const http_request_header_t *header = &request->headers[i];
+        printf ("\t%.*s: %.*s\r\n", (int) header->key.len, http_request_slice (request, header->key),
+            (int) header->value.len, http_request_slice (request, header->value));
+    }
 }
 
-/// Updates the HTTP request when type state is specified.
-int32_t __http_request_update__type (http_request_t *request, char *line) {
-    char *save_ptr = NULL, *tok = NULL;
-    size_t len;
+/// Finds the header with the specified key (case insensitive), returns NULL
+/// if the request does not have it.
+const http_request_header_t *http_request_find_header (const http_request_t *request, const char *key) {
+    for (uint32_t i = 0; i < request->header_count; ++i) {
+        const http_request_header_t *header = &request->headers[i];
+        if (strncicmp (http_request_slice (request, header->key), header->key.len, key))
+            return header;
+    }
 
-    // HTTP Method
-    if ((tok = strtok_r (line, " ", &save_ptr)) == NULL)
-        return -1;
-    request->method = http_method_from_string (tok);
+    return NULL;
+}
+
+/// Gets the next token of the line which ends at end, the spaces before it
+/// are skipped. Returns -1 if there are no tokens left.
+int32_t __http_request_next_token (http_request_t *request, size_t *offset, size_t end, http_slice_t *token) {
+    size_t i = *offset;
 
-    // Path
-    if ((tok = strtok_r (NULL, " ", &save_ptr)) == NULL)
+    while (i < end && request->buffer[i] == ' ')
+        ++i;
+    if (i == end)
         return -1;
 
-    len = strlen (tok) + 1;
-    request->url = (char *) malloc (len);
-    memcpy (request->url, tok, len);
-    
-    // Version
-    if ((tok = strtok_r (NULL, " ", &save_ptr)) == NULL)
+    token->offset = (uint32_t) i;
+    while (i < end && request->buffer[i] != ' ')
+        ++i;
+    token->len = (uint32_t) (i - token->offset);
+
+    *offset = i;
+    return 0;
+}
+
+/// Updates the HTTP request when type state is specified.
+int32_t __http_request_update__type (http_request_t *request, size_t offset, size_t len) {
+    size_t end = offset + len;
+    http_slice_t version;
+
+    // Empty lines before the request line are ignored.
+    if (len == 0)
+        return 0;
+
+    // Splits the line into the method, the target and the version.
+    if (__http_request_next_token (request, &offset, end, &request->method_name) != 0 ||
+        __http_request_next_token (request, &offset, end, &request->target) != 0 ||
+        __http_request_next_token (request, &offset, end, &version) != 0)
         return -1;
-    request->version = http_version_from_string (tok);
+
+    // Terminates the tokens in place, the byte after the method and the target
+    //  is a space, and the one after the version the line terminator.
+    request->buffer[request->method_name.offset + request->method_name.len] = '\0';
+    request->buffer[request->target.offset + request->target.len] = '\0';
+    request->buffer[version.offset + version.len] = '\0';
+
+    request->method = http_method_from_string (http_request_slice (request, request->method_name));
+    request->version = http_version_from_string (http_request_slice (request, version));
 
     // Parses the path.
-    if (http_url_parse (&request->parsed_url, request->url) != 0) {
+    if (http_url_parse (&request->parsed_url, request->buffer, request->target) != 0)
         return -1;
-    }
 
     // Sets the next state, and returns 0.
     request->state = HTTP_REQUEST_STATE_RECEIVING_HEADERS;
@@ -116,31 +151,81 @@ int32_t __http_request_update__type (http_request_t *request, char *line) {
 }
 
 /// Updates the HTTP request when header state is specified.
-int32_t __http_request_update__headers (http_request_t *request, char *line) {
+int32_t __http_request_update__headers (http_request_t *request, size_t offset, size_t len) {
+    uint8_t *buffer = request->buffer;
+
     // Checks if we're not dealing with an empty line, if so parse the header
     //  and return 0 (if no errors).
-    if (!(strcmp (line, "") == 0)) {
-        if (__http_parse_header (line, request->headers) != 0)
+    if (len != 0) {
+        if (request->header_count == HTTP_REQUEST_MAX_HEADERS)
+            return -1;
+
+        // The colon splits the key from the value.
+        uint8_t *colon = memchr (&buffer[offset], ':', len);
+        if (colon == NULL)
+            return -1;
+
+        size_t key_start = offset, key_end = (size_t) (colon - buffer);
+        size_t value_start = key_end + 1, value_end = offset + len;
+
+        // Skips the whitespace around the key and the value, instead of
+        //  moving them.
+        while (key_start < key_end && (buffer[key_start] == ' ' || buffer[key_start] == '\t'))
+            ++key_start;
+        while (key_end > key_start && (buffer[key_end - 1] == ' ' || buffer[key_end - 1] == '\t'))
+            --key_end;
+        while (value_start < value_end && (buffer[value_start] == ' ' || buffer[value_start] == '\t'))
+            ++value_start;
+        while (value_end > value_start && (buffer[value_end - 1] == ' ' || buffer[value_end - 1] == '\t'))
+            --value_end;
+
+        if (key_start == key_end)
             return -1;
-        
+
+        // Terminates both in place, the byte after the key is the colon or
+        //  whitespace, and the one after the value whitespace or the line
+        //  terminator.
+        buffer[key_end] = '\0';
+        buffer[value_end] = '\0';
+
+        http_request_header_t *header = &request->headers[request->header_count++];
+        header->key.offset = (uint32_t) key_start;
+        header->key.len = (uint32_t) (key_end - key_start);
+        header->value.offset = (uint32_t) value_start;
+        header->value.len = (uint32_t) (value_end - value_start);
+
         return 0;
     }
     
-    // Since the HTTP protocol is one big fucking inneficient mess, there are no true indicators
-    //  for request bodies, and that's why we're required to check the content-type and content-length
-    //  to check if any body may possibly be supplied.
-
-    http_header_t *header = NULL;
-    if ((header = http_headers_find_by_key (request->headers, "content-type")) != NULL) {
-        request->content_type = http_content_type_from_string (header->value);
+    const http_request_header_t *header = NULL;
+    if ((header = http_request_find_header (request, "content-type")) != NULL) {
+        request->content_type = http_content_type_from_string (http_request_slice (request, header->value));
     }
 
-    if ((header = http_headers_find_by_key (request->headers, "content-length")) != NULL) {
-        request->expected_body_size = (size_t) atol (header->value);
+    // The body is framed by its Content-Length alone, whatever its type, since anything
+    //  we do not read as the body would be read as the next pipelined request. We can't
+    //  decode other framings, so those requests are refused.
+    if (http_request_find_header (request, "transfer-encoding") != NULL)
+        return -1;
+
+    bool has_length = false;
+    for (uint32_t i = 0; i < request->header_count; ++i) {
+        header = &request->headers[i];
+        if (!strncicmp (http_request_slice (request, header->key), header->key.len, "content-length"))
+            continue;
+
+        // Repeated lengths must agree, otherwise it's unclear where the body ends.
+        size_t length;
+        if (__http_request_parse_content_length (request, header->value, &length) != 0 ||
+            (has_length && length != request->expected_body_size))
+            return -1;
+
+        request->expected_body_size = length;
+        has_length = true;
     }
 
     // Checks if we're going to read an body or not.
-    if (request->content_type != HTTP_CONTENT_TYPE_UNKNOWN && request->expected_body_size > 0)
+    if (request->expected_body_size > 0)
         request->state = HTTP_REQUEST_STATE_RECEIVING_BODY;
     else
         request->state = HTTP_REQUEST_STATE_DONE;
@@ -148,17 +233,45 @@ int32_t __http_request_update__headers (http_request_t *request, char *line) {
     return 0;
 }
 
-/// Updates the HTTP request with the specified data, this will process it further.
-int32_t http_request_update (http_request_t *request, uint8_t *data) {
+/// Parses the value of a Content-Length header, which must consist of digits
+/// only. Returns -1 if it does not, or if it does not fit.
+int32_t __http_request_parse_content_length (http_request_t *request, http_slice_t value, size_t *result) {
+    const char *digits = http_request_slice (request, value);
+    size_t length = 0;
+
+    if (value.len == 0)
+        return -1;
+
+    for (uint32_t i = 0; i < value.len; ++i) {
+        if (digits[i] < '0' || digits[i] > '9')
+            return -1;
+
+        size_t digit = (size_t) (digits[i] - '0');
+        if (length > (SIZE_MAX - digit) / 10)
+            return -1;
+
+        length = length * 10 + digit;
+    }
+
+    *result = length;
+    return 0;
+}
+
+/// Updates the HTTP request with the line of len bytes at offset in the
+/// buffer, without its line terminator, this will process it further.
+int32_t http_request_update (http_request_t *request, uint8_t *buffer, size_t offset, size_t len) {
+    // The buffer may have grown since the previous line, the slices stay the same.
+    request->buffer = buffer;
+
     switch (request->state) {
     // When receiving the type.
     case HTTP_REQUEST_STATE_RECEIVING_TYPE:
-        if (__http_request_update__type (request, (char *) data) != 0)
+        if (__http_request_update__type (request, offset, len) != 0)
             return -1;
         break;
     // When receiving headers.
     case HTTP_REQUEST_STATE_RECEIVING_HEADERS:
-        if (__http_request_update__headers (request, (char *) data) != 0)
+        if (__http_request_update__headers (request, offset, len) != 0)
             return -1;
         break;
     // When receiving body.
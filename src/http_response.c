@@ -21,7 +21,9 @@ const char *X_SERVER_HEADER_KEY = "Server";
 const char *X_SERVER_HEADER_VALUE_NAME = "LukeHTTP V1.0";
 
 const char *DATE_HEADER_KEY = "Date";
-const char *DATE_HEADER__DATE_FORMAT = "%a, %d %b %Y %X %Z";
+
+const char *CONNECTION_KEY = "Connection";
+const char *CONNECTION_KEEP_ALIVE = "keep-alive";
 
 const char *CONTENT_TYPE_KEY = "Content-Type";
 const char *CONTENT_LENGTH_KEY = "Content-Length";
@@ -30,6 +32,11 @@ const char *ACCEPT_RANGES_KEY = "Accept-Ranges";
 const char *RANGE_KEY = "Range";
 
 http_headers_t *g_DefaultHeaders = NULL;
+uint8_t *g_DefaultHeaderBlock = NULL;
+size_t g_DefaultHeaderOffsets[HTTP_RESPONSE_MAX_DEFAULT_HEADERS + 1];
+size_t g_DefaultHeaderCount = 0;
+http_file_cache_t g_FileCache;
+http_response_cache_t g_ResponseCache;
 
 /// Creates new HTTP response.
 http_response_t *http_response_new(void) {
@@ -57,6 +64,16 @@ int32_t http_response_free(http_response_t **response) {
   return 0;
 }
 
+/// Resets an HTTP response so it can be used for the next request on the
+///  same connection, the header nodes are kept for reuse.
+void http_response_reset(http_response_t *response) {
+  http_headers_clear(response->headers);
+
+  response->code = 0;
+  response->method = HTTP_METHOD_INVALID;
+  response->version = HTTP_VERSION_INVALID;
+}
+
 /// Adds the X-Server header to the specified headers.
 int32_t __http_add_x_server_header(char *buffer, size_t buffer_size,
                                    http_headers_t *headers) {
@@ -81,20 +98,25 @@ int32_t __http_add_x_server_header(char *buffer, size_t buffer_size,
   return 0;
 }
 
-/// Adds the Date header to the specified headers.
-int32_t __http_add_date_header(char *buffer, size_t buffer_size,
-                               http_headers_t *headers) {
-  time_t t;
-  struct tm *t_info;
+/// Appends the Date header with the date of the current second to the
+///  output buffer, without enqueueing it.
+int32_t __http_response_serialize_date(http_socket_t *socket) {
+  size_t key_len = strlen(DATE_HEADER_KEY);
 
-  t = time(NULL);
-  t_info = localtime(&t);
+  uint8_t *p = http_socket_output_reserve(socket, key_len + HTTP_DATE_SIZE + 4);
+  if (p == NULL)
+    return -1;
 
-  strftime(buffer, buffer_size, DATE_HEADER__DATE_FORMAT, t_info);
-  http_headers_insert(headers, DATE_HEADER_KEY, buffer,
-                      HTTP_HEADER_INSERT_FLAG_COPY_VALUE |
-                          HTTP_HEADER_INSERT_FLAG_END);
+  memcpy(p, DATE_HEADER_KEY, key_len);
+  p += key_len;
+  *p++ = ':';
+  *p++ = ' ';
+  memcpy(p, http_date_get(), HTTP_DATE_SIZE);
+  p += HTTP_DATE_SIZE;
+  *p++ = '\r';
+  *p++ = '\n';
 
+  socket->output_level += key_len + HTTP_DATE_SIZE + 4;
   return 0;
 }
 
@@ -109,16 +131,16 @@ int32_t __http_add_content_type_header(char *buffer, size_t buffer_size,
   http_headers_insert(headers, CONTENT_TYPE_KEY, buffer,
                       HTTP_HEADER_INSERT_FLAG_COPY_VALUE |
                           HTTP_HEADER_INSERT_FLAG_END);
-  http_headers_insert(headers, "Connection", "keep-alive",
-                      HTTP_HEADER_INSERT_FLAG_COPY_VALUE |
-                          HTTP_HEADER_INSERT_FLAG_END);
 
   return 0;
 }
 
 int32_t __http_add_content_length_header(char *buffer, size_t buffer_size,
                                          http_headers_t *headers, size_t len) {
-  snprintf(buffer, buffer_size, "%lu", len);
+  if (buffer_size < 21)
+    return -1;
+
+  u64_to_string(buffer, len);
   http_headers_insert(headers, CONTENT_LENGTH_KEY, buffer,
                       HTTP_HEADER_INSERT_FLAG_COPY_VALUE |
                           HTTP_HEADER_INSERT_FLAG_END);
@@ -155,171 +177,455 @@ int32_t http_response_prepare_default_headers(void) {
   }
 
   free(buffer);
+
+  http_headers_insert(g_DefaultHeaders, CONNECTION_KEY, CONNECTION_KEEP_ALIVE,
+                      HTTP_HEADER_INSERT_FLAG_END);
+
+  return __http_response_render_default_headers();
+}
+
+/// Renders the default headers once into a single block, in the same format
+///  they're written to the socket, and remembers where every header starts.
+int32_t __http_response_render_default_headers(void) {
+  size_t size = 0;
+  size_t count = 0;
+
+  for (http_header_t *header = g_DefaultHeaders->start; header != NULL;
+       header = header->next) {
+    size += strlen(header->key) + strlen(header->value) + 4;
+    ++count;
+  }
+
+  if (count > HTTP_RESPONSE_MAX_DEFAULT_HEADERS)
+    return -1;
+
+  g_DefaultHeaderBlock = (uint8_t *)malloc(size);
+  if (g_DefaultHeaderBlock == NULL)
+    return -1;
+
+  uint8_t *p = g_DefaultHeaderBlock;
+  count = 0;
+
+  for (http_header_t *header = g_DefaultHeaders->start; header != NULL;
+       header = header->next) {
+    size_t key_len = strlen(header->key);
+    size_t value_len = strlen(header->value);
+
+    g_DefaultHeaderOffsets[count++] = (size_t)(p - g_DefaultHeaderBlock);
+
+    memcpy(p, header->key, key_len);
+    p += key_len;
+    *p++ = ':';
+    *p++ = ' ';
+    memcpy(p, header->value, value_len);
+    p += value_len;
+    *p++ = '\r';
+    *p++ = '\n';
+  }
+
+  g_DefaultHeaderOffsets[count] = size;
+  g_DefaultHeaderCount = count;
+
   return 0;
 }
 
 /// Gets called to free the default headers.
 int32_t http_response_free_default_headers(void) {
+  free(g_DefaultHeaderBlock);
+  g_DefaultHeaderBlock = NULL;
+  g_DefaultHeaderCount = 0;
+
   return http_headers_free(&g_DefaultHeaders);
 }
 
-/// Adds the default HTTP headers.
-int32_t __http_response_add_default_headers(http_response_t *response) {
-  static const size_t buffer_size = 2048;
-  char *buffer = (char *)malloc(buffer_size);
-  if (buffer == NULL)
-    return -1;
+/// Checks if the headers of the response contain one with the specified key,
+///  which then takes the place of the default header.
+bool __http_response_overrides(http_response_t *response, const char *key) {
+  for (http_header_t *header = response->headers->start; header != NULL;
+       header = header->next) {
+    if (strcicmp(header->key, key))
+      return true;
+  }
 
-  if (http_headers_add_all(response->headers, g_DefaultHeaders) == -1) {
-    free(buffer);
-    return -1;
-  } else if (__http_add_date_header(buffer, buffer_size, response->headers) ==
-             -1) {
-    free(buffer);
-    return -1;
+  return false;
+}
+
+/// Adds the part of the default header block between the specified offsets
+///  to the response, either by reference or copied into the output buffer.
+int32_t __http_response_splice_default_range(http_socket_t *socket,
+                                             size_t start, size_t end,
+                                             bool copy) {
+  if (end == start)
+    return 0;
+  else if (copy)
+    return http_socket_output_append(socket, &g_DefaultHeaderBlock[start],
+                                     end - start);
+
+  // The block lives as long as the server, so it's never copied nor freed.
+  http_socket_write_op_t op;
+  http_socket_write_op_create__binary(&op, &g_DefaultHeaderBlock[start],
+                                      end - start, false);
+
+  return http_socket_enqueue_write_op(socket, &op);
+}
+
+/// Adds the default headers the response does not override, the ones next
+///  to each other are added as a single part of the block.
+int32_t __http_response_splice_default_headers(http_socket_t *socket,
+                                               http_response_t *response,
+                                               bool copy) {
+  size_t start = 0;
+  size_t i = 0;
+
+  // Only merges when the route added headers of its own.
+  if (response->headers->start != NULL) {
+    for (http_header_t *header = g_DefaultHeaders->start; header != NULL;
+         header = header->next, ++i) {
+      if (!__http_response_overrides(response, header->key))
+        continue;
+
+      if (__http_response_splice_default_range(
+              socket, start, g_DefaultHeaderOffsets[i], copy) != 0)
+        return -1;
+
+      start = g_DefaultHeaderOffsets[i + 1];
+    }
   }
 
-  free(buffer);
+  return __http_response_splice_default_range(
+      socket, start, g_DefaultHeaderOffsets[g_DefaultHeaderCount], copy);
+}
 
-  return 0;
+/// Gets called at startup of server, prepares the caches of the static
+///  files and of the complete responses of the small ones.
+int32_t http_response_prepare_caches(void) {
+  if (http_file_cache_init(&g_FileCache) != 0)
+    return -1;
+
+  return http_response_cache_init(&g_ResponseCache);
 }
 
-/// Writes an text response to the client.
+/// Gets called to free the caches, this closes the cached files.
+void http_response_free_caches(void) {
+  http_response_cache_free(&g_ResponseCache);
+  http_file_cache_free(&g_FileCache);
+}
+
+/// Releases the cached file of a write operation, once it's been sent.
+void __http_response_release_file(void *entry) {
+  http_file_cache_entry_release((http_file_cache_entry_t *)entry);
+}
+
+/// Releases the cached response of a write operation, once it's been sent.
+void __http_response_release_cached(void *entry) {
+  http_response_cache_entry_release((http_response_cache_entry_t *)entry);
+}
+
+/// Writes an text response to the client, the text is copied into the
+///  output buffer right after the head.
 int32_t http_response_write_text(http_socket_t *socket,
                                  http_response_t *response,
                                  http_content_type_t type, const char *text) {
-  static const size_t buffer_size = 128;
-  char *buffer = (char *)malloc(buffer_size);
+  char buffer[128];
+  size_t len = strlen(text);
 
-  if (__http_response_add_default_headers(response) != 0) {
-    free(buffer);
-    return -1;
-  } else if (__http_add_content_type_header(buffer, buffer_size,
-                                            response->headers, type) != 0) {
-    free(buffer);
+  if (__http_add_content_type_header(buffer, sizeof(buffer),
+                                          response->headers, type) != 0)
     return -2;
-  } else if (__http_add_content_length_header(
-                 buffer, buffer_size, response->headers, strlen(text)) != 0) {
-    free(buffer);
+  else if (__http_add_content_length_header(buffer, sizeof(buffer),
+                                            response->headers, len) != 0)
     return -3;
-  }
 
-  free(buffer);
+  if (http_write_response_head(socket, response) != 0 ||
+      http_response_write_headers(socket, response) != 0)
+    return -4;
 
-  http_write_response_head(socket, response);
-  http_response_write_headers(socket, response);
-  http_socket_enqueue_write_op(
-      socket,
-      http_socket_write_op_create__binary((uint8_t *)text, strlen(text), true));
+  // Appends the body, this extends the operation of the head.
+  size_t offset = socket->output_level;
+  if (http_socket_output_append(socket, text, len) != 0 ||
+      http_socket_enqueue_output(socket, offset) != 0)
+    return -5;
 
   return 0;
 }
 
-/// Writes an file to the client.
-int32_t http_response_write_file(http_socket_t *socket,
-                                 http_response_t *response, const char *path) {
-  // Opens the file specified in the arguments, if this fails print an error
-  //  and return -1.
-  FILE *file = fopen(path, "r");
-  if (file == NULL) {
-    if (errno != ENOENT)
-      perror("fopen () error");
-    return -1;
+/// Builds the cached response of a small file, the head is serialized into
+///  the output buffer of the socket, and moved from there into the entry.
+http_response_cache_entry_t *
+__http_response_cache_build(http_socket_t *socket, http_response_t *response,
+                            const char *path, http_file_cache_entry_t *file) {
+  // The Date header is the only one which changes, so it's left out, the
+  //  default headers are copied into the entry.
+  size_t offset = socket->output_level;
+  if (__http_response_serialize_head(socket, response) != 0 ||
+      __http_response_serialize_headers(socket, response) != 0 ||
+      __http_response_splice_default_headers(socket, response, true) != 0 ||
+      http_socket_output_append(socket, file->headers, file->headers_len) !=
+          0) {
+    socket->output_level = offset;
+    return NULL;
   }
 
-  // Allocates the buffer used for header generation.
-  static const size_t buffer_size = 128;
-  char *buffer = (char *)malloc(buffer_size);
+  http_response_cache_entry_t *entry = http_response_cache_entry_new(
+      path, http_response_get_code(response),
+      http_response_get_version(response), socket->output_level - offset,
+      file);
+  if (entry != NULL)
+    memcpy(entry->bytes, &socket->output[offset], entry->head_len);
 
-  // Get the size of the specified file, by seeking to the end, getting the
-  // offset
-  //  and rewinding.
-  fseek(file, 0L, SEEK_END);
-  size_t size = ftell(file);
-  rewind(file);
+  // Nothing has been enqueued, so just forget the serialized head.
+  socket->output_level = offset;
 
-  // Gets the content type.
-  http_content_type_t type = http_content_type_from_ext(path_get_ext(path));
-  if (type == HTTP_CONTENT_TYPE_UNKNOWN)
-    type = HTTP_CONTENT_TYPE_APPLICATION_OCTET_STREAM;
+  return entry;
+}
 
-  // Adds the default headers, content type and content length headers.
-  if (__http_response_add_default_headers(response) != 0) {
-    free(buffer);
-    return -1;
-  } else if (__http_add_content_type_header(buffer, buffer_size,
-                                            response->headers, type) != 0) {
-    free(buffer);
+/// Writes a cached response, the head and the body are sent from the entry
+///  itself, with the Date header in between, all in a single gather write.
+int32_t __http_response_write_cached(http_socket_t *socket,
+                                     http_response_t *response,
+                                     http_response_cache_entry_t *entry) {
+  // The head of the entry, this operation takes over the reference.
+  http_socket_write_op_t op;
+  http_socket_write_op_create__binary(&op, entry->bytes, entry->head_len,
+                                      false);
+  op.release = __http_response_release_cached;
+  op.release_arg = entry;
+
+  if (http_socket_enqueue_write_op(socket, &op) != 0) {
+    http_response_cache_entry_release(entry);
     return -2;
-  } else if (__http_add_content_length_header(buffer, buffer_size,
-                                              response->headers, size) != 0) {
-    free(buffer);
-    return -3;
   }
 
-  __http_add_accept_range_header(buffer, buffer_size, response->headers,
-                                 HTTP_ACCEPT_RANGE_BYTES);
+  // The Date header, which is copied into the output buffer.
+  size_t offset = socket->output_level;
 
-  // Sends the HTTP response head, and the headers immediately after.
-  http_write_response_head(socket, response);
-  http_response_write_headers(socket, response);
+  if (__http_response_serialize_date(socket) != 0 ||
+      http_socket_enqueue_output(socket, offset) != 0)
+    return -3;
 
-  // Checks if we need to write body.
-  if (http_response_get_method(response) != HTTP_METHOD_HEAD) {
-    http_socket_write_op_t *op = http_socket_write_op_create(
-        HTTP_SOCKET_WRITE_OP_FILE, file, HTTP_SOCKET_WRITE_OP_FLAG__CLOSE_FD);
-    if (op == NULL) {
-      free(buffer);
-      return -1;
-    }
+  // The empty line and the body, which takes another reference.
+  size_t body_len = entry->size - entry->head_len;
+  if (http_response_get_method(response) == HTTP_METHOD_HEAD)
+    body_len = 2;
+
+  http_response_cache_entry_retain(entry);
+  http_socket_write_op_create__binary(&op, &entry->bytes[entry->head_len],
+                                      body_len, false);
+  op.release = __http_response_release_cached;
+  op.release_arg = entry;
 
-    op->size = size;
-    http_socket_enqueue_write_op(socket, op);
-  } else {
-    if (fclose(file) != 0)
-      perror("fclose () failed");
+  if (http_socket_enqueue_write_op(socket, &op) != 0) {
+    http_response_cache_entry_release(entry);
+    return -4;
   }
 
-  // Frees thje header buffer, and returns 0.
-  free(buffer);
   return 0;
 }
 
-void __http_response_write_headers__write_method(const char *header, void *u) {
-  http_socket_t *socket = (http_socket_t *)u;
-  http_socket_enqueue_write_op(
-      socket, http_socket_write_op_create__binary((uint8_t *)header,
-                                                  strlen(header), true));
+/// Writes an file to the client, the file comes from the static file cache,
+///  so a hot file needs no system calls besides the sendfile. Small files
+///  are sent from the response cache, without touching the file at all.
+///  Returns -1 if the file can not be served, nothing has been written then,
+///  any other negative value means writing the response failed after all.
+int32_t http_response_write_file(http_socket_t *socket,
+                                 http_response_t *response, const char *path) {
+  // A response is only cached if the route did not add headers of its own.
+  bool cacheable = response->headers->start == NULL;
+  bool fresh = false;
+
+  http_response_cache_entry_t *cached = NULL;
+  if (cacheable) {
+    cached = http_response_cache_get(&g_ResponseCache, path,
+                                     http_response_get_code(response),
+                                     http_response_get_version(response),
+                                     &fresh);
+    if (cached != NULL && fresh)
+      return __http_response_write_cached(socket, response, cached);
+  }
+
+  // Gets the open file, if it can not be served return -1.
+  http_file_cache_entry_t *entry = http_file_cache_get(&g_FileCache, path);
+  if (entry == NULL) {
+    if (cached != NULL)
+      http_response_cache_entry_release(cached);
+    return -1;
+  }
+
+  // The cached response expired, if the file did not change trust it again,
+  //  otherwise build it again from the new file.
+  if (cached != NULL) {
+    if (http_response_cache_entry_matches(cached, entry)) {
+      http_response_cache_entry_refresh(cached);
+      http_file_cache_entry_release(entry);
+      return __http_response_write_cached(socket, response, cached);
+    }
+
+    http_response_cache_entry_release(cached);
+  }
+
+  // If the response can not be cached, for example when we're out of memory,
+  //  or the file shrunk while reading it, it's sent like a large one.
+  if (cacheable && entry->size <= HTTP_RESPONSE_CACHE_MAX_FILE_SIZE &&
+      (cached = __http_response_cache_build(socket, response, path, entry)) !=
+          NULL) {
+    http_file_cache_entry_release(entry);
+
+    http_response_cache_insert(&g_ResponseCache, cached);
+    return __http_response_write_cached(socket, response, cached);
+  }
+
+  // Sends the HTTP response head, and the headers immediately after, the
+  //  ones describing the file are pre-rendered in the cache entry.
+  if (http_write_response_head(socket, response) != 0 ||
+      __http_response_write_headers(socket, response, entry->headers,
+                                    entry->headers_len) != 0) {
+    http_file_cache_entry_release(entry);
+    return -4;
+  }
+
+  // Checks if we need to write body, the operation shares the descriptor of
+  //  the cache, and releases the entry once it's done.
+  if (http_response_get_method(response) != HTTP_METHOD_HEAD) {
+    http_socket_write_op_t op;
+    http_socket_write_op_create__fd(&op, entry->fd, 0, entry->size, 0);
+    op.release = __http_response_release_file;
+    op.release_arg = entry;
+
+    if (http_socket_enqueue_write_op(socket, &op) != 0) {
+      http_file_cache_entry_release(entry);
+      return -5;
+    }
+  } else
+    http_file_cache_entry_release(entry);
+
+  return 0;
 }
 
-/// Writes the HTTP response headers.
+/// Writes the HTTP response headers, the default headers and the Date
+///  header, and the empty line which terminates them.
 int32_t http_response_write_headers(http_socket_t *socket,
                                     http_response_t *response) {
-  if (http_headers_to_string_no_collapse(
-          response->headers, __http_response_write_headers__write_method,
-          (void *)socket) != 0)
+  return __http_response_write_headers(socket, response, NULL, 0);
+}
+
+/// Writes the HTTP response headers, the default headers, the Date header
+///  followed by an already rendered block of headers, and the empty line
+///  which terminates them. The default headers are sent from their block.
+int32_t __http_response_write_headers(http_socket_t *socket,
+                                      http_response_t *response,
+                                      const char *block, size_t block_len) {
+  size_t offset = socket->output_level;
+
+  if (__http_response_serialize_headers(socket, response) != 0)
+    return -1;
+  else if (socket->output_level > offset &&
+           http_socket_enqueue_output(socket, offset) != 0)
     return -1;
 
-  http_socket_enqueue_write_op(
-      socket, http_socket_write_op_create__binary((uint8_t *)"\r\n", 2, false));
+  if (__http_response_splice_default_headers(socket, response, false) != 0)
+    return -2;
+
+  offset = socket->output_level;
+
+  if (__http_response_serialize_date(socket) != 0 ||
+      (block_len > 0 &&
+       http_socket_output_append(socket, block, block_len) != 0) ||
+      http_socket_output_append(socket, "\r\n", 2) != 0)
+    return -3;
+
+  return http_socket_enqueue_output(socket, offset);
+}
+
+/// Serializes the HTTP response headers into the output buffer, without
+///  enqueueing them.
+int32_t __http_response_serialize_headers(http_socket_t *socket,
+                                          http_response_t *response) {
+  // Serializes every header, by walking the list directly.
+  for (http_header_t *header = response->headers->start; header != NULL;
+       header = header->next) {
+    size_t key_len = strlen(header->key);
+    size_t value_len = strlen(header->value);
+
+    uint8_t *p = http_socket_output_reserve(socket, key_len + value_len + 4);
+    if (p == NULL)
+      return -1;
+
+    memcpy(p, header->key, key_len);
+    p += key_len;
+    *p++ = ':';
+    *p++ = ' ';
+    memcpy(p, header->value, value_len);
+    p += value_len;
+    *p++ = '\r';
+    *p++ = '\n';
+
+    socket->output_level += key_len + value_len + 4;
+  }
+
   return 0;
 }
 
 /// Writes an HTTP response head.
 int32_t http_write_response_head(http_socket_t *socket,
                                  http_response_t *response) {
-  char buffer[98];
-
-  // Formats the response string.
-  snprintf(buffer, sizeof(buffer) / sizeof(char), "%s %u %s\r\n",
-           http_version_to_string(http_response_get_version(response)),
-           http_response_get_code(response),
-           http_code_get_message(http_response_get_code(response)));
-
-  // Writes the response string to the socket.
-  http_socket_enqueue_write_op(
-      socket, http_socket_write_op_create__binary((uint8_t *)buffer,
-                                                  strlen(buffer), true));
+  size_t offset = socket->output_level;
+
+  if (__http_response_serialize_head(socket, response) != 0)
+    return -1;
+
+  return http_socket_enqueue_output(socket, offset);
+}
+
+/// Serializes the status line into the output buffer, without enqueueing it.
+int32_t __http_response_serialize_head(http_socket_t *socket,
+                                       http_response_t *response) {
+  // The lines of the known codes are formatted already, so just copy them.
+  const http_status_line_t *status_line = http_status_line_get(
+      http_response_get_version(response), http_response_get_code(response));
+  if (status_line == NULL)
+    return __http_response_format_head(socket, response);
+
+  return http_socket_output_append(socket, status_line->line,
+                                   status_line->len);
+}
+
+/// Formats the status line of a code without a reason phrase into the output
+///  buffer, without enqueueing it.
+int32_t __http_response_format_head(http_socket_t *socket,
+                                    http_response_t *response) {
+  // Gets the parts of the status line, the reason phrase may be empty.
+  const char *version =
+      http_version_to_string(http_response_get_version(response));
+  if (version == NULL)
+    version = http_version_to_string(HTTP_VERSION_1_1);
+
+  const char *message = http_code_get_message(http_response_get_code(response));
+  if (message == NULL)
+    message = "";
+
+  char code[21];
+  size_t version_len = strlen(version);
+  size_t code_len = u64_to_string(code, http_response_get_code(response));
+  size_t message_len = strlen(message);
+  size_t size = version_len + code_len + message_len + 4;
+
+  // Serializes the status line into the output buffer.
+  uint8_t *p = http_socket_output_reserve(socket, size);
+  if (p == NULL)
+    return -1;
+
+  memcpy(p, version, version_len);
+  p += version_len;
+  *p++ = ' ';
+  memcpy(p, code, code_len);
+  p += code_len;
+  *p++ = ' ';
+  memcpy(p, message, message_len);
+  p += message_len;
+  *p++ = '\r';
+  *p++ = '\n';
+
+  socket->output_level += size;
 
   return 0;
 }
@@ -0,0 +1,260 @@
+/*
+    Copyright 2021 Luke A.C.A. Rieff
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "http_response_cache.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// HTTP Response Cache Entry
+///////////////////////////////////////////////////////////////////////////////
+
+/// Creates an entry for the response of the specified file, with room for
+///  head_len bytes of head, the empty line and the body. The body is read
+///  from the file, the head must be filled in by the caller.
+http_response_cache_entry_t *
+http_response_cache_entry_new(const char *path, uint32_t code,
+                              uint32_t version, size_t head_len,
+                              http_file_cache_entry_t *file) {
+  size_t path_size = strlen(path) + 1;
+  size_t size = head_len + 2 + (size_t)file->size;
+
+  // Allocates the entry, its path and its bytes at once.
+  http_response_cache_entry_t *entry = (http_response_cache_entry_t *)malloc(
+      sizeof(http_response_cache_entry_t) + path_size + size);
+  if (entry == NULL)
+    return NULL;
+
+  memset(entry, 0, sizeof(http_response_cache_entry_t));
+
+  char *p = (char *)&entry[1];
+  memcpy(p, path, path_size);
+
+  entry->path = p;
+  entry->hash = __http_response_cache_hash(path, code, version);
+  entry->code = code;
+  entry->version = version;
+  entry->refs = 1;
+  entry->referenced = 1;
+  entry->expires = http_timer_wheel_now() + HTTP_RESPONSE_CACHE_TTL;
+  entry->dev = file->dev;
+  entry->ino = file->ino;
+  entry->file_size = file->size;
+  entry->mtime = file->mtime;
+  entry->head_len = head_len;
+  entry->size = size;
+  entry->bytes = (uint8_t *)&p[path_size];
+
+  entry->bytes[head_len] = '\r';
+  entry->bytes[head_len + 1] = '\n';
+
+  // Reads the body, the descriptor is shared, so don't move its offset.
+  uint8_t *body = &entry->bytes[head_len + 2];
+  for (off_t offset = 0; offset < file->size;) {
+    ssize_t rc =
+        pread(file->fd, &body[offset], (size_t)(file->size - offset), offset);
+    if (rc < 0 && errno == EINTR)
+      continue;
+    else if (rc <= 0) {
+      if (rc < 0)
+        perror("pread () failed");
+      free(entry);
+      return NULL;
+    }
+
+    offset += rc;
+  }
+
+  return entry;
+}
+
+/// Checks if the entry has been built from the file of the file cache entry.
+bool http_response_cache_entry_matches(http_response_cache_entry_t *entry,
+                                       http_file_cache_entry_t *file) {
+  return entry->dev == file->dev && entry->ino == file->ino &&
+         entry->file_size == file->size &&
+         entry->mtime.tv_sec == file->mtime.tv_sec &&
+         entry->mtime.tv_nsec == file->mtime.tv_nsec;
+}
+
+/// Trusts the entry for another period.
+void http_response_cache_entry_refresh(http_response_cache_entry_t *entry) {
+  __atomic_store_n(&entry->expires,
+                   http_timer_wheel_now() + HTTP_RESPONSE_CACHE_TTL,
+                   __ATOMIC_RELAXED);
+}
+
+/// Takes an extra reference to an entry.
+void http_response_cache_entry_retain(http_response_cache_entry_t *entry) {
+  __atomic_add_fetch(&entry->refs, 1, __ATOMIC_RELAXED);
+}
+
+/// Drops a reference to an entry, the last one frees it.
+void http_response_cache_entry_release(http_response_cache_entry_t *entry) {
+  if (__atomic_sub_fetch(&entry->refs, 1, __ATOMIC_ACQ_REL) == 0)
+    free(entry);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// HTTP Response Cache
+///////////////////////////////////////////////////////////////////////////////
+
+/// Hashes the key of a cached response.
+uint64_t __http_response_cache_hash(const char *path, uint32_t code,
+                                    uint32_t version) {
+  uint64_t hash = string_hash(path);
+
+  hash ^= ((uint64_t)code << 8) | version;
+  hash *= 1099511628211ULL;
+
+  return hash;
+}
+
+/// Finds the entry with the specified key, the cache must be locked.
+http_response_cache_entry_t *
+__http_response_cache_find(http_response_cache_t *cache, uint64_t hash,
+                           const char *path, uint32_t code, uint32_t version) {
+  http_response_cache_entry_t *entry =
+      cache->buckets[hash & (HTTP_RESPONSE_CACHE_BUCKETS - 1)];
+
+  for (; entry != NULL; entry = entry->next) {
+    if (entry->hash == hash && entry->code == code &&
+        entry->version == version && strcmp(entry->path, path) == 0)
+      return entry;
+  }
+
+  return NULL;
+}
+
+/// Removes an entry from the write locked cache, and drops its reference.
+void __http_response_cache_remove(http_response_cache_t *cache,
+                                  http_response_cache_entry_t *entry) {
+  http_response_cache_entry_t **p =
+      &cache->buckets[entry->hash & (HTTP_RESPONSE_CACHE_BUCKETS - 1)];
+  while (*p != entry)
+    p = &(*p)->next;
+  *p = entry->next;
+
+  // Fills the slot with the last entry of the clock.
+  http_response_cache_entry_t *last = cache->clock[--cache->count];
+  cache->clock[entry->slot] = last;
+  last->slot = entry->slot;
+
+  if (cache->hand >= cache->count)
+    cache->hand = 0;
+
+  cache->bytes -= entry->size;
+  http_response_cache_entry_release(entry);
+}
+
+/// Evicts one entry from the write locked cache, the hand skips (and clears)
+///  the entries which have been used since it last passed them.
+void __http_response_cache_evict(http_response_cache_t *cache) {
+  for (;;) {
+    http_response_cache_entry_t *entry = cache->clock[cache->hand];
+
+    if (__atomic_exchange_n(&entry->referenced, 0, __ATOMIC_RELAXED) == 0) {
+      __http_response_cache_remove(cache, entry);
+      return;
+    }
+
+    if (++cache->hand == cache->count)
+      cache->hand = 0;
+  }
+}
+
+/// Initializes a response cache.
+int32_t http_response_cache_init(http_response_cache_t *cache) {
+  memset(cache, 0, sizeof(http_response_cache_t));
+
+  if (pthread_rwlock_init(&cache->lock, NULL) != 0) {
+    perror("pthread_rwlock_init () failed");
+    return -1;
+  }
+
+  return 0;
+}
+
+/// Frees a response cache, the entries which are still referenced are freed
+///  once they're released.
+void http_response_cache_free(http_response_cache_t *cache) {
+  while (cache->count > 0)
+    __http_response_cache_remove(cache, cache->clock[0]);
+
+  pthread_rwlock_destroy(&cache->lock);
+}
+
+/// Gets the cached response with the specified key, which the caller must
+///  release, fresh tells if it is still within its time to live. Returns
+///  NULL if it is not cached.
+http_response_cache_entry_t *
+http_response_cache_get(http_response_cache_t *cache, const char *path,
+                        uint32_t code, uint32_t version, bool *fresh) {
+  uint64_t hash = __http_response_cache_hash(path, code, version);
+
+  // A hit only marks the entry, so all pools can share the read lock.
+  pthread_rwlock_rdlock(&cache->lock);
+
+  http_response_cache_entry_t *entry =
+      __http_response_cache_find(cache, hash, path, code, version);
+  if (entry != NULL) {
+    http_response_cache_entry_retain(entry);
+
+    if (__atomic_load_n(&entry->referenced, __ATOMIC_RELAXED) == 0)
+      __atomic_store_n(&entry->referenced, 1, __ATOMIC_RELAXED);
+  }
+
+  pthread_rwlock_unlock(&cache->lock);
+
+  if (entry != NULL)
+    *fresh = __atomic_load_n(&entry->expires, __ATOMIC_RELAXED) >
+             http_timer_wheel_now();
+
+  return entry;
+}
+
+/// Inserts an entry into the cache, replacing the one with the same key, the
+///  reference of the caller stays with the caller.
+void http_response_cache_insert(http_response_cache_t *cache,
+                                http_response_cache_entry_t *entry) {
+  if (entry->size > HTTP_RESPONSE_CACHE_SIZE)
+    return;
+
+  pthread_rwlock_wrlock(&cache->lock);
+
+  http_response_cache_entry_t *existing = __http_response_cache_find(
+      cache, entry->hash, entry->path, entry->code, entry->version);
+  if (existing != NULL)
+    __http_response_cache_remove(cache, existing);
+
+  // Makes room, both in entries and in bytes.
+  while (cache->count > 0 &&
+         (cache->count == HTTP_RESPONSE_CACHE_MAX_ENTRIES ||
+          cache->bytes + entry->size > HTTP_RESPONSE_CACHE_SIZE))
+    __http_response_cache_evict(cache);
+
+  // The cache holds a reference of its own.
+  http_response_cache_entry_retain(entry);
+
+  http_response_cache_entry_t **bucket =
+      &cache->buckets[entry->hash & (HTTP_RESPONSE_CACHE_BUCKETS - 1)];
+  entry->next = *bucket;
+  *bucket = entry;
+
+  entry->slot = cache->count;
+  cache->clock[cache->count++] = entry;
+  cache->bytes += entry->size;
+
+  pthread_rwlock_unlock(&cache->lock);
+}
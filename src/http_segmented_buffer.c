@@ -27,8 +27,11 @@ http_segmented_buffer_t *http_segmented_buffer_create(void) {
 
 /// Frees an http segmented buffer.
 void http_segmented_buffer_free(http_segmented_buffer_t **buffer) {
-  // Checks if there are any elements left, if so remove free them.
-  http_segmented_buffer__segment_t *segment = (*buffer)->start;
+  // Moves the segments which are left to the unused list.
+  http_segmented_buffer_clear(*buffer);
+
+  // Frees the unused segments.
+  http_segmented_buffer__segment_t *segment = (*buffer)->unused;
   while (segment != NULL) {
     // Stores the next segment as temp, and frees it.
     http_segmented_buffer__segment_t *next = segment->next;
@@ -44,6 +47,71 @@ void http_segmented_buffer_free(http_segmented_buffer_t **buffer) {
   *buffer = NULL;
 }
 
+/// Removes all the segments of an http segmented buffer, the segments are
+///  kept on the unused list up to HTTP_SEGMENTED_BUFFER_MAX_UNUSED_SIZE bytes,
+///  so their memory can be used again, the rest is freed.
+void http_segmented_buffer_clear(http_segmented_buffer_t *buffer) {
+  http_segmented_buffer__segment_t *segment = buffer->start;
+  while (segment != NULL) {
+    http_segmented_buffer__segment_t *next = segment->next;
+
+    // Frees the segment if keeping it would hold on to more memory than
+    //  a regular request needs, the body of a large one must not stay
+    //  allocated for the next connections of the socket.
+    if (buffer->unused_size + segment->capacity >
+        HTTP_SEGMENTED_BUFFER_MAX_UNUSED_SIZE) {
+      free(segment->bytes);
+      free(segment);
+    } else {
+      segment->next = buffer->unused;
+      buffer->unused = segment;
+      buffer->unused_size += segment->capacity;
+    }
+
+    segment = next;
+  }
+
+  buffer->start = buffer->end = NULL;
+  buffer->segment_count = 0;
+}
+
+/// Takes a segment which can hold size bytes, from the unused list if there
+///  is one, else it allocates a new segment.
+http_segmented_buffer__segment_t *
+http_segmented_buffer_take_segment(http_segmented_buffer_t *buffer,
+                                   size_t size) {
+  http_segmented_buffer__segment_t *res = buffer->unused;
+  if (res == NULL) {
+    res = (http_segmented_buffer__segment_t *)calloc(
+        1, sizeof(http_segmented_buffer__segment_t));
+    if (res == NULL)
+      return NULL;
+  } else {
+    buffer->unused = res->next;
+    buffer->unused_size -= res->capacity;
+  }
+
+  // Grows the memory of the segment if it is too small.
+  if (res->capacity < size) {
+    uint8_t *bytes = (uint8_t *)realloc(res->bytes, size);
+    if (bytes == NULL) {
+      res->next = buffer->unused;
+      buffer->unused = res;
+      buffer->unused_size += res->capacity;
+      return NULL;
+    }
+
+    res->bytes = bytes;
+    res->capacity = size;
+  }
+
+  res->written = 0;
+  res->total = size;
+  res->next = res->prev = NULL;
+
+  return res;
+}
+
 /// Creates a new segment.
 http_segmented_buffer__segment_t *
 http_segmented_buffer_segment_create_from_string(const char *string) {
@@ -66,6 +134,7 @@ http_segmented_buffer_segment_create_from_string(const char *string) {
   }
 
   memcpy(res->bytes, string, res->total + 1);
+  res->capacity = res->total + 1;
 
   // Returns the result.
   return res;
@@ -82,6 +151,7 @@ http_segmented_buffer_segment_create(uint8_t *bytes, size_t len) {
 
   res->bytes = bytes;
   res->total = len;
+  res->capacity = len;
 
   return res;
 }
@@ -20,107 +20,114 @@
 // HTTP Socket Write Operation
 ///////////////////////////////////////////////////////////////////////////////
 
-/// Creates an write operation.
-http_socket_write_op_t *
-http_socket_write_op_create(http_socket_write_op_type_t type, void *data,
-                            uint32_t flags) {
-  // Allocates the structure memory, and returns NULL if failed.
-  http_socket_write_op_t *res =
-      (http_socket_write_op_t *)calloc(1, sizeof(http_socket_write_op_t));
-  if (res == NULL)
-    return NULL;
+/// Initializes an write operation.
+void http_socket_write_op_create(http_socket_write_op_t *op,
+                                 http_socket_write_op_type_t type, void *data,
+                                 uint32_t flags) {
+  memset(op, 0, sizeof(http_socket_write_op_t));
 
   // Sets the type of write operation, and the flags.
-  res->op = type;
-  res->flags = flags;
+  op->op = type;
+  op->flags = flags;
 
   // Checks the type of operation, and how to interpret the *data.
   switch (type) {
   case HTTP_SOCKET_WRITE_OP_BYTES:
-    res->bytes = (uint8_t *)data;
+    op->bytes = (uint8_t *)data;
     break;
   case HTTP_SOCKET_WRITE_OP_FILE:
-    res->file = (FILE *)data;
+    // The file descriptor and range are set by http_socket_write_op_create__fd.
+    op->fd = -1;
     break;
   default:
     break;
   }
+}
 
-  return res;
+/// Initializes an file write operation, which sends length bytes starting at
+///  offset of the specified file descriptor.
+void http_socket_write_op_create__fd(http_socket_write_op_t *op, int32_t fd,
+                                     off_t offset, off_t length,
+                                     uint32_t flags) {
+  http_socket_write_op_create(op, HTTP_SOCKET_WRITE_OP_FILE, NULL, flags);
+
+  op->fd = fd;
+  op->file_offset = offset;
+  op->file_end = offset + length;
+  op->size = (size_t)length;
 }
 
-/// Creates an file write operation, for the specified file path.
-http_socket_write_op_t *http_socket_write_op_create__file(const char *path) {
+/// Initializes an file write operation, for the complete file at the
+///  specified path.
+int32_t http_socket_write_op_create__file(http_socket_write_op_t *op,
+                                          const char *path) {
   // Opens the specified file with read permissions, since thjere is no
   //  way we're going to write to it.
-  FILE *fp = fopen(path, "r");
-  if (fp == NULL) {
-    perror("fopen () failed");
-    return NULL;
+  int32_t fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    perror("open () failed");
+    return -1;
   }
 
-  // Returns the resulting write operation
-  http_socket_write_op_t *res = http_socket_write_op_create(
-      HTTP_SOCKET_WRITE_OP_FILE, fp, HTTP_SOCKET_WRITE_OP_FLAG__CLOSE_FD);
-  if (res == NULL) {
-    // Double error LMFAO.
-    if (fclose(fp) != 0)
-      perror("fclose () failed");
-    return NULL;
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    perror("fstat () failed");
+    close(fd);
+    return -1;
   }
 
-  // Returns the res op.
-  return res;
+  http_socket_write_op_create__fd(op, fd, 0, st.st_size,
+                                  HTTP_SOCKET_WRITE_OP_FLAG__CLOSE_FD);
+  return 0;
 }
 
-/// Creates an binary write operation where the memory get's either copied, or
-/// just referenced.
-http_socket_write_op_t *http_socket_write_op_create__binary(uint8_t *data,
-                                                            size_t size,
-                                                            bool should_copy) {
-  // Checks if we're supposed to copy, if so replace the data with copy address.
-  if (should_copy) {
+/// Initializes an binary write operation where the memory get's either
+/// copied, or just referenced. Small copies are stored inside the operation.
+int32_t http_socket_write_op_create__binary(http_socket_write_op_t *op,
+                                            uint8_t *data, size_t size,
+                                            bool should_copy) {
+  if (should_copy && size <= HTTP_SOCKET_WRITE_OP_INLINE_SIZE) {
+    http_socket_write_op_create(op, HTTP_SOCKET_WRITE_OP_BYTES, NULL,
+                                HTTP_SOCKET_WRITE_OP_FLAG__INLINE);
+    memcpy(op->inline_bytes, data, size);
+  } else if (should_copy) {
     uint8_t *copy = (uint8_t *)malloc(size);
     if (copy == NULL)
-      return NULL;
+      return -1;
 
     memcpy(copy, data, size);
-    data = copy;
-  }
-
-  // Creates the resulting write operation.
-  http_socket_write_op_t *res = http_socket_write_op_create(
-      HTTP_SOCKET_WRITE_OP_BYTES, data,
-      should_copy ? HTTP_SOCKET_WRITE_OP_FLAG__FREE_BYTES : 0);
-  if (res == NULL) {
-    if (should_copy)
-      free(data);
-    return NULL;
-  }
-
-  res->size = size;
+    http_socket_write_op_create(op, HTTP_SOCKET_WRITE_OP_BYTES, copy,
+                                HTTP_SOCKET_WRITE_OP_FLAG__FREE_BYTES);
+  } else
+    http_socket_write_op_create(op, HTTP_SOCKET_WRITE_OP_BYTES, data, 0);
 
-  // Returns the res op.
-  return res;
+  op->size = size;
+  return 0;
 }
 
-/// Frees an write operation.
-int32_t http_socket_write_op_free(http_socket_write_op_t **op) {
+/// Frees the resources of an write operation.
+int32_t http_socket_write_op_free(http_socket_write_op_t *op) {
   // Checks the type of operation, and how to free it.
-  switch (op[0]->op) {
+  switch (op->op) {
   case HTTP_SOCKET_WRITE_OP_BYTES:
-    if (!(op[0]->flags & HTTP_SOCKET_WRITE_OP_FLAG__FREE_BYTES))
+    if (!(op->flags & HTTP_SOCKET_WRITE_OP_FLAG__FREE_BYTES))
       break;
 
-    free(op[0]->bytes);
+    free(op->bytes);
 
     break;
   case HTTP_SOCKET_WRITE_OP_FILE:
-    if (!(op[0]->flags & HTTP_SOCKET_WRITE_OP_FLAG__CLOSE_FD))
+    // Closes the pipe of the splice fallback, if it has been used.
+    if (op->flags & HTTP_SOCKET_WRITE_OP_FLAG__SPLICE) {
+      close(op->pipe[0]);
+      close(op->pipe[1]);
+    }
+
+    if (!(op->flags & HTTP_SOCKET_WRITE_OP_FLAG__CLOSE_FD))
       break;
 
-    if (fclose(op[0]->file) != 0) {
-      perror("fclose () failed");
+    if (close(op->fd) != 0) {
+      perror("close () failed");
       return -1;
     }
 
@@ -130,115 +137,634 @@ int32_t http_socket_write_op_free(http_socket_write_op_t **op) {
     return -2;
   }
 
-  // Frees the operation structure.
-  free(*op);
-  *op = NULL;
+  // Releases the shared resource, if the operation has one.
+  if (op->release != NULL)
+    op->release(op->release_arg);
 
   // Returns 0, to indicate free went properly.
   return 0;
 }
 
-/// Writes an bytes to the socket.
+/// Gets the bytes of a byte operation, these are either owned by the operation
+///  (possibly inline), or stored in the output buffer of the socket.
+uint8_t *__http_socket_write_op_bytes(http_socket_t *socket,
+                                      http_socket_write_op_t *op) {
+  if (op->flags & HTTP_SOCKET_WRITE_OP_FLAG__OUTPUT)
+    return &socket->output[op->output_offset];
+  else if (op->flags & HTTP_SOCKET_WRITE_OP_FLAG__INLINE)
+    return op->inline_bytes;
+
+  return op->bytes;
+}
+
+/// Checks if a byte operation is sent with MSG_ZEROCOPY, which is the case for
+///  large buffers owned by the operation, once the socket has it enabled.
+bool __http_socket_write_op_is_zerocopy(http_socket_t *socket,
+                                        http_socket_write_op_t *op) {
+  if (!(socket->flags & HTTP_SOCKET_FLAG_ZEROCOPY) ||
+      op->op != HTTP_SOCKET_WRITE_OP_BYTES ||
+      !(op->flags & HTTP_SOCKET_WRITE_OP_FLAG__FREE_BYTES))
+    return false;
+
+  // Once the kernel holds part of the buffer, the rest goes the same way.
+  return (op->flags & HTTP_SOCKET_WRITE_OP_FLAG__ZEROCOPY) ||
+         op->size - op->bytes_written >= HTTP_SOCKET_ZEROCOPY_THRESHOLD;
+}
+
+/// Writes an bytes to the socket, at most budget bytes are written.
 int32_t __http_socket_write_op_write__bytes(http_socket_t *socket,
-                                            http_socket_write_op_t *op) {
-  int32_t rc = write(socket->fd, &op->bytes[op->bytes_written],
-                     op->size - op->bytes_written);
+                                            http_socket_write_op_t *op,
+                                            size_t budget) {
+  uint8_t *bytes = __http_socket_write_op_bytes(socket, op);
+  size_t count = op->size - op->bytes_written;
+  if (count > budget)
+    count = budget;
+
+  // Large owned buffers are sent without copying them, the kernel then keeps
+  //  referencing the pages until it reports the completion.
+  bool zerocopy = __http_socket_write_op_is_zerocopy(socket, op);
+
+  ssize_t rc = send(socket->fd, &bytes[op->bytes_written], count,
+                    MSG_NOSIGNAL | (zerocopy ? MSG_ZEROCOPY : 0));
+  if (rc == -1 && zerocopy && errno == ENOBUFS) {
+    // The socket ran out of option memory to track the pinned pages, so
+    //  this chunk is simply copied.
+    zerocopy = false;
+    rc = send(socket->fd, &bytes[op->bytes_written], count, MSG_NOSIGNAL);
+  }
 
   if (rc == -1) {
-    if (errno != EPIPE) // We don't care about PIPE lol!
-      perror("write () failed");
+    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+      return HTTP_SOCKET_WRITE_OP_BLOCKED;
+    else if (errno != EPIPE && errno != ECONNRESET)
+      perror("send () failed");
     return -1;
-  } else if (rc == (int32_t)op->size) {
-    return 1;
-  } else
-    op->bytes_written += (size_t)rc;
+  }
 
-  return 0;
+  // Every successful zero-copy send gets the next id of the socket, the
+  //  buffer must live until the last one which referenced it completes.
+  if (zerocopy) {
+    op->flags |= HTTP_SOCKET_WRITE_OP_FLAG__ZEROCOPY;
+    op->zerocopy_id = socket->zerocopy_next++;
+  }
+
+  socket->bytes_sent += (size_t)rc;
+  op->bytes_written += (size_t)rc;
+
+  if (op->bytes_written == op->size)
+    return HTTP_SOCKET_WRITE_OP_DONE;
+
+  return (size_t)rc < count ? HTTP_SOCKET_WRITE_OP_BLOCKED
+                            : HTTP_SOCKET_WRITE_OP_PARTIAL;
 }
 
-/// Writes an file to the socket.
-int32_t __http_socket_write_op_write__file(http_socket_t *socket,
-                                           http_socket_write_op_t *op) {
-  FILE *file = op->file;
-  int32_t rc;
+/// Writes an file to the socket through a pipe, this is the fallback for
+///  files which do not support sendfile, at most budget bytes are written.
+int32_t __http_socket_write_op_write__splice(http_socket_t *socket,
+                                             http_socket_write_op_t *op,
+                                             size_t budget) {
+  // Fills the pipe from the file, once the previous chunk has left it.
+  if (op->pipe_level == 0) {
+    off_t count = op->file_end - op->file_offset;
+    if (count > (off_t)budget)
+      count = (off_t)budget;
+
+    ssize_t rc = splice(op->fd, &op->file_offset, op->pipe[1], NULL,
+                        (size_t)count, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    if (rc < 0) {
+      perror("splice () failed");
+      return -1;
+    } else if (rc == 0) {
+      fprintf(stderr, "splice () reached the end of file too early.\r\n");
+      return -1;
+    }
 
-  if ((rc = sendfile(socket->fd, fileno(file), &op->file_offset, op->size)) <
-      0) {
-    if (errno == EWOULDBLOCK)
-      return 0;
+    op->pipe_level = (size_t)rc;
+  }
+
+  // Moves the chunk from the pipe to the socket.
+  size_t count = op->pipe_level;
+  ssize_t rc = splice(op->pipe[0], NULL, socket->fd, NULL, count,
+                      SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+  if (rc < 0) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+      return HTTP_SOCKET_WRITE_OP_BLOCKED;
     else if (errno != EPIPE && errno != ECONNRESET)
+      perror("splice () failed");
+    return -1;
+  }
+
+  socket->bytes_sent += (size_t)rc;
+  op->bytes_written += (size_t)rc;
+  op->pipe_level -= (size_t)rc;
+
+  if (op->pipe_level == 0 && op->file_offset == op->file_end)
+    return HTTP_SOCKET_WRITE_OP_DONE;
+
+  return (size_t)rc < count ? HTTP_SOCKET_WRITE_OP_BLOCKED
+                            : HTTP_SOCKET_WRITE_OP_PARTIAL;
+}
+
+/// Writes an file to the socket, at most budget bytes are written. The
+///  offsets are 64-bit, so files larger than 2 GiB are streamed as well.
+int32_t __http_socket_write_op_write__file(http_socket_t *socket,
+                                           http_socket_write_op_t *op,
+                                           size_t budget) {
+  if (op->flags & HTTP_SOCKET_WRITE_OP_FLAG__SPLICE)
+    return __http_socket_write_op_write__splice(socket, op, budget);
+
+  off_t count = op->file_end - op->file_offset;
+  if (count == 0)
+    return HTTP_SOCKET_WRITE_OP_DONE;
+  else if (count > (off_t)budget)
+    count = (off_t)budget;
+
+  ssize_t rc = sendfile(socket->fd, op->fd, &op->file_offset, (size_t)count);
+  if (rc < 0) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+      return HTTP_SOCKET_WRITE_OP_BLOCKED;
+
+    // Some files (for example on special file systems) do not support
+    //  sendfile, those go through a pipe with splice instead.
+    if (errno == EINVAL || errno == ENOSYS) {
+      if (pipe2(op->pipe, O_CLOEXEC | O_NONBLOCK) != 0) {
+        perror("pipe2 () failed");
+        return -1;
+      }
+
+      op->flags |= HTTP_SOCKET_WRITE_OP_FLAG__SPLICE;
+      return __http_socket_write_op_write__splice(socket, op, budget);
+    }
+
+    if (errno != EPIPE && errno != ECONNRESET)
       perror("sendfile () failed");
     return -1;
   } else if (rc == 0) {
-    return 1;
+    // The file got shorter than the Content-Length we've sent, there is no
+    //  way to finish the response anymore.
+    fprintf(stderr, "sendfile () reached the end of file too early.\r\n");
+    return -1;
   }
 
-  return 0;
+  socket->bytes_sent += (size_t)rc;
+  op->bytes_written += (size_t)rc;
+
+  if (op->file_offset == op->file_end)
+    return HTTP_SOCKET_WRITE_OP_DONE;
+
+  return rc < count ? HTTP_SOCKET_WRITE_OP_BLOCKED
+                    : HTTP_SOCKET_WRITE_OP_PARTIAL;
 }
 
-/// Writes the specified operation.
+/// Writes the consecutive byte operations at the front of the queue with a
+///  single gather write, at most budget bytes are written. The completely
+///  written operations are dequeued.
+int32_t __http_socket_write_op_write__gather(http_socket_t *socket,
+                                             size_t budget) {
+  struct iovec iov[HTTP_SOCKET_WRITE_GATHER_MAX];
+  size_t iov_count = 0, total = 0;
+  bool capped = false;
+
+  // Collects the byte operations, starting at the oldest one, until we reach
+  //  an operation of a different type, a zero-copy one, or the budget.
+  for (size_t i = socket->write_head; i != socket->write_tail &&
+                                      iov_count < HTTP_SOCKET_WRITE_GATHER_MAX &&
+                                      total < budget;
+       ++i) {
+    http_socket_write_op_t *op = __http_socket_write_queue_at(socket, i);
+    if (op->op != HTTP_SOCKET_WRITE_OP_BYTES ||
+        __http_socket_write_op_is_zerocopy(socket, op))
+      break;
+
+    size_t len = op->size - op->bytes_written;
+    if (len > budget - total) {
+      len = budget - total;
+      capped = true;
+    }
+
+    iov[iov_count].iov_base =
+        &__http_socket_write_op_bytes(socket, op)[op->bytes_written];
+    iov[iov_count].iov_len = len;
+
+    total += iov[iov_count++].iov_len;
+  }
+
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = iov;
+  msg.msg_iovlen = iov_count;
+
+  // If the head is followed by a file, or a zero-copy body, tell the kernel
+  //  more is coming, so the head and the first body chunk share full
+  //  segments. The send of that chunk does not set it, so it pushes
+  //  everything out again.
+  int32_t flags = MSG_NOSIGNAL;
+  size_t next = socket->write_head + iov_count;
+  if (!capped && next != socket->write_tail) {
+    http_socket_write_op_t *op = __http_socket_write_queue_at(socket, next);
+    if ((op->op == HTTP_SOCKET_WRITE_OP_FILE &&
+         op->file_offset < op->file_end) ||
+        __http_socket_write_op_is_zerocopy(socket, op))
+      flags |= MSG_MORE;
+  }
+
+  ssize_t rc = sendmsg(socket->fd, &msg, flags);
+  if (rc == -1) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+      return HTTP_SOCKET_WRITE_OP_BLOCKED;
+    else if (errno != EPIPE && errno != ECONNRESET)
+      perror("sendmsg () failed");
+    return -1;
+  }
+
+  socket->bytes_sent += (size_t)rc;
+
+  // Dequeues the operations which have been written completely, the written
+  //  bytes of the last one may only partially cover it.
+  size_t written = (size_t)rc;
+  while (socket->n_pending_write_ops > 0) {
+    http_socket_write_op_t *op = http_socket_write_queue_front(socket);
+    if (op->op != HTTP_SOCKET_WRITE_OP_BYTES)
+      break;
+
+    size_t remaining = op->size - op->bytes_written;
+    if (written < remaining) {
+      op->bytes_written += written;
+      break;
+    }
+
+    written -= remaining;
+    http_socket_dequeue_write_op(socket);
+  }
+
+  return (size_t)rc < total ? HTTP_SOCKET_WRITE_OP_BLOCKED
+                            : HTTP_SOCKET_WRITE_OP_DONE;
+}
+
+/// Writes the specified operation, at most budget bytes are written.
 int32_t http_socket_write_op_write(http_socket_t *socket,
-                                   http_socket_write_op_t *op) {
+                                   http_socket_write_op_t *op, size_t budget) {
   switch (op->op) {
   case HTTP_SOCKET_WRITE_OP_BYTES:
-    return __http_socket_write_op_write__bytes(socket, op);
+    return __http_socket_write_op_write__bytes(socket, op, budget);
   case HTTP_SOCKET_WRITE_OP_FILE:
-    return __http_socket_write_op_write__file(socket, op);
+    return __http_socket_write_op_write__file(socket, op, budget);
   default:
     break;
   }
 
+  fprintf(stderr, "Invalid operation type for socket write operation.\r\n");
+  return -1;
+}
+
+/// Gets the operation at the specified (unmasked) position of the queue.
+http_socket_write_op_t *__http_socket_write_queue_at(http_socket_t *socket,
+                                                     size_t i) {
+  return &socket->write_ops[i & (socket->write_ops_capacity - 1)];
+}
+
+/// Gets the oldest operation of the queue, which is the one being written.
+http_socket_write_op_t *http_socket_write_queue_front(http_socket_t *socket) {
+  return __http_socket_write_queue_at(socket, socket->write_head);
+}
+
+/// Gets the newest operation of the queue.
+http_socket_write_op_t *http_socket_write_queue_back(http_socket_t *socket) {
+  return __http_socket_write_queue_at(socket, socket->write_tail - 1);
+}
+
+/// Doubles the capacity of the write queue, the first time the operations
+///  move from the socket itself to the heap.
+int32_t __http_socket_write_queue_grow(http_socket_t *socket) {
+  size_t capacity = socket->write_ops_capacity * 2;
+  http_socket_write_op_t *ops = (http_socket_write_op_t *)malloc(
+      capacity * sizeof(http_socket_write_op_t));
+  if (ops == NULL)
+    return -1;
+
+  // Copies the operations in order, so the oldest one ends up first.
+  size_t count = socket->write_tail - socket->write_head;
+  for (size_t i = 0; i < count; ++i)
+    ops[i] = *__http_socket_write_queue_at(socket, socket->write_head + i);
+
+  if (socket->write_ops != socket->write_ops_inline)
+    free(socket->write_ops);
+
+  socket->write_ops = ops;
+  socket->write_ops_capacity = capacity;
+  socket->write_head = 0;
+  socket->write_tail = count;
+
   return 0;
 }
 
-/// Enqueues an write operation when there is nothing else inside.
-void __http_socket_enqueue_write_op__single(http_socket_t *socket,
-                                            http_socket_write_op_t *op) {
-  op->next = NULL;
-  op->prev = NULL;
+/// Resets the write queue of a socket, this makes it use the operations
+///  inside the socket, unless it already grew to the heap.
+void __http_socket_write_queue_init(http_socket_t *socket) {
+  if (socket->write_ops_capacity <= HTTP_SOCKET_WRITE_QUEUE_INLINE_SIZE) {
+    socket->write_ops = socket->write_ops_inline;
+    socket->write_ops_capacity = HTTP_SOCKET_WRITE_QUEUE_INLINE_SIZE;
+  }
+
+  socket->write_head = socket->write_tail = 0;
+  socket->n_pending_write_ops = 0;
+}
+
+/// Frees the write queue of a socket, including the resources of the
+///  operations which are still inside.
+void __http_socket_write_queue_free(http_socket_t *socket) {
+  while (socket->n_pending_write_ops > 0)
+    http_socket_dequeue_write_op(socket);
 
-  socket->write_start = op;
-  socket->write_end = op;
+  if (socket->write_ops != socket->write_ops_inline)
+    free(socket->write_ops);
 
-  ++socket->n_pending_write_ops;
+  socket->write_ops = NULL;
+  socket->write_ops_capacity = 0;
 }
 
-/// Enqueues an write operation when there is already one inside.
-void __http_socket_enqueue_write_op__multiple(http_socket_t *socket,
-                                              http_socket_write_op_t *op) {
-  op->next = socket->write_start;
-  op->prev = NULL;
+/// Enqueues an write operation to http socket, the operation is copied into
+///  the queue, which only allocates when it has to grow.
+int32_t http_socket_enqueue_write_op(http_socket_t *socket,
+                                     const http_socket_write_op_t *op) {
+  if (socket->write_tail - socket->write_head == socket->write_ops_capacity &&
+      __http_socket_write_queue_grow(socket) != 0)
+    return -1;
 
-  socket->write_start->prev = op;
-  socket->write_start = op;
+  *__http_socket_write_queue_at(socket, socket->write_tail++) = *op;
 
   ++socket->n_pending_write_ops;
-}
+  socket->write_bytes_pending += op->size;
 
-/// Enqueues an write operation to http socket.
-void http_socket_enqueue_write_op(http_socket_t *socket,
-                                  http_socket_write_op_t *op) {
-  if (socket->n_pending_write_ops == 0)
-    __http_socket_enqueue_write_op__single(socket, op);
-  else
-    __http_socket_enqueue_write_op__multiple(socket, op);
+  return 0;
 }
 
-/// Dequeues the last element from the queue, most likely called when written.
+/// Dequeues the oldest operation from the queue, most likely called when
+///  written.
 void http_socket_dequeue_write_op(http_socket_t *socket) {
-  http_socket_write_op_t *op = socket->write_end;
+  http_socket_write_op_t *op = http_socket_write_queue_front(socket);
 
-  if (socket->n_pending_write_ops > 1) {
-    socket->write_end->prev->next = NULL;
-    socket->write_end = socket->write_end->prev;
-  } else {
-    socket->write_start = NULL;
-    socket->write_end = NULL;
+  socket->write_bytes_pending -= op->size;
+
+  // The kernel may still send from a zero-copy buffer, so the socket holds on
+  //  to it until the completion arrives, if that's impossible we rather leak
+  //  it than let it be reused under the kernel.
+  if (op->flags & HTTP_SOCKET_WRITE_OP_FLAG__ZEROCOPY) {
+    if (__http_socket_zerocopy_retain(socket, op->bytes, op->zerocopy_id) != 0)
+      fprintf(stderr, "Leaking zero-copy buffer, out of memory.\r\n");
+
+    op->flags &= ~HTTP_SOCKET_WRITE_OP_FLAG__FREE_BYTES;
+  }
+
+  http_socket_write_op_free(op);
+
+  ++socket->write_head;
+
+  // Once everything has been written, the output buffer can be reused from
+  //  the start.
+  if (--socket->n_pending_write_ops == 0)
+    socket->output_level = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// HTTP Socket Output Buffer
+///////////////////////////////////////////////////////////////////////////////
+
+/// Makes sure the output buffer of the socket can hold size more bytes, and
+///  returns where to write them.
+uint8_t *http_socket_output_reserve(http_socket_t *socket, size_t size) {
+  if (socket->output_size - socket->output_level < size) {
+    size_t new_size = socket->output_size != 0 ? socket->output_size
+                                               : HTTP_SOCKET_OUTPUT_BUFFER_SIZE;
+    while (new_size - socket->output_level < size)
+      new_size *= 2;
+
+    // The queued operations refer to the buffer by offset, so it may move.
+    uint8_t *output = (uint8_t *)realloc(socket->output, new_size);
+    if (output == NULL)
+      return NULL;
+
+    socket->output = output;
+    socket->output_size = new_size;
+  }
+
+  return &socket->output[socket->output_level];
+}
+
+/// Appends the specified bytes to the output buffer of the socket.
+int32_t http_socket_output_append(http_socket_t *socket, const void *data,
+                                  size_t size) {
+  uint8_t *p = http_socket_output_reserve(socket, size);
+  if (p == NULL)
+    return -1;
+
+  memcpy(p, data, size);
+  socket->output_level += size;
+
+  return 0;
+}
+
+/// Enqueues the bytes which have been appended to the output buffer since
+///  offset, this extends the previous operation if it ends at offset.
+int32_t http_socket_enqueue_output(http_socket_t *socket, size_t offset) {
+  size_t size = socket->output_level - offset;
+
+  // Checks if the newest operation is the part of the output buffer right
+  //  before this one, if so just make it larger.
+  if (socket->n_pending_write_ops > 0) {
+    http_socket_write_op_t *last = http_socket_write_queue_back(socket);
+    if ((last->flags & HTTP_SOCKET_WRITE_OP_FLAG__OUTPUT) &&
+        last->output_offset + last->size == offset) {
+      last->size += size;
+      socket->write_bytes_pending += size;
+      return 0;
+    }
+  }
+
+  http_socket_write_op_t op;
+  http_socket_write_op_create(&op, HTTP_SOCKET_WRITE_OP_BYTES, NULL,
+                              HTTP_SOCKET_WRITE_OP_FLAG__OUTPUT);
+  op.output_offset = offset;
+  op.size = size;
+
+  return http_socket_enqueue_write_op(socket, &op);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// HTTP Socket Zero-Copy
+///////////////////////////////////////////////////////////////////////////////
+
+/// Holds on to a buffer which has been sent with MSG_ZEROCOPY, until the
+///  kernel completed the send call with the specified id.
+int32_t __http_socket_zerocopy_retain(http_socket_t *socket, uint8_t *bytes,
+                                      uint32_t id) {
+  if (socket->zerocopy_tail == socket->zerocopy_capacity) {
+    // Moves the buffers to the start if the completed ones left room there,
+    //  otherwise doubles the capacity.
+    if (socket->zerocopy_head > 0) {
+      memmove(socket->zerocopy_buffers,
+              &socket->zerocopy_buffers[socket->zerocopy_head],
+              (socket->zerocopy_tail - socket->zerocopy_head) *
+                  sizeof(http_socket_zerocopy_buffer_t));
+      socket->zerocopy_tail -= socket->zerocopy_head;
+      socket->zerocopy_head = 0;
+    } else {
+      size_t capacity = socket->zerocopy_capacity != 0
+                            ? socket->zerocopy_capacity * 2
+                            : HTTP_SOCKET_ZEROCOPY_BUFFERS;
+      http_socket_zerocopy_buffer_t *buffers =
+          (http_socket_zerocopy_buffer_t *)realloc(
+              socket->zerocopy_buffers,
+              capacity * sizeof(http_socket_zerocopy_buffer_t));
+      if (buffers == NULL)
+        return -1;
+
+      socket->zerocopy_buffers = buffers;
+      socket->zerocopy_capacity = capacity;
+    }
+  }
+
+  http_socket_zerocopy_buffer_t *buffer =
+      &socket->zerocopy_buffers[socket->zerocopy_tail++];
+  buffer->bytes = bytes;
+  buffer->id = id;
+
+  // The completion may already have been read, for example when the buffer
+  //  was written by an earlier event.
+  __http_socket_zerocopy_release(socket);
+
+  return 0;
+}
+
+/// Frees the retained buffers whose send calls have been completed.
+void __http_socket_zerocopy_release(http_socket_t *socket) {
+  // The buffers are retained in the order they were sent, the ids wrap, so
+  //  compare their distance to the first id which did not complete yet.
+  while (socket->zerocopy_head != socket->zerocopy_tail) {
+    http_socket_zerocopy_buffer_t *buffer =
+        &socket->zerocopy_buffers[socket->zerocopy_head];
+    if ((int32_t)(buffer->id - socket->zerocopy_done) >= 0)
+      break;
+
+    free(buffer->bytes);
+    ++socket->zerocopy_head;
+  }
+
+  if (socket->zerocopy_head == socket->zerocopy_tail)
+    socket->zerocopy_head = socket->zerocopy_tail = 0;
+}
+
+/// Marks the send calls with the ids first up to last as completed, ranges
+///  beyond one which did not complete yet are kept until it did.
+int32_t __http_socket_zerocopy_complete_range(http_socket_t *socket,
+                                              uint32_t first, uint32_t last) {
+  // The kernel usually completes the send calls in order, but not always,
+  //  for example when it had to copy the data after all, so a range beyond
+  //  the first id which did not complete yet waits for it.
+  if ((int32_t)(first - socket->zerocopy_done) > 0) {
+    if (socket->zerocopy_n_ranges == socket->zerocopy_ranges_capacity) {
+      size_t capacity = socket->zerocopy_ranges_capacity != 0
+                            ? socket->zerocopy_ranges_capacity * 2
+                            : HTTP_SOCKET_ZEROCOPY_RANGES;
+      http_socket_zerocopy_range_t *ranges =
+          (http_socket_zerocopy_range_t *)realloc(
+              socket->zerocopy_ranges,
+              capacity * sizeof(http_socket_zerocopy_range_t));
+      if (ranges == NULL)
+        return -1;
+
+      socket->zerocopy_ranges = ranges;
+      socket->zerocopy_ranges_capacity = capacity;
+    }
+
+    http_socket_zerocopy_range_t *range =
+        &socket->zerocopy_ranges[socket->zerocopy_n_ranges++];
+    range->first = first;
+    range->last = last;
+
+    return 0;
+  }
+
+  if ((int32_t)(last + 1 - socket->zerocopy_done) > 0)
+    socket->zerocopy_done = last + 1;
+
+  // Takes the kept ranges which are no longer beyond a gap, every one taken
+  //  may close the gap of another, so it starts over.
+  for (size_t i = 0; i < socket->zerocopy_n_ranges;) {
+    http_socket_zerocopy_range_t *range = &socket->zerocopy_ranges[i];
+    if ((int32_t)(range->first - socket->zerocopy_done) > 0) {
+      ++i;
+      continue;
+    }
+
+    if ((int32_t)(range->last + 1 - socket->zerocopy_done) > 0)
+      socket->zerocopy_done = range->last + 1;
+
+    *range = socket->zerocopy_ranges[--socket->zerocopy_n_ranges];
+    i = 0;
+  }
+
+  return 0;
+}
+
+/// Reads the zero-copy completions from the error queue of the socket, and
+///  frees the buffers the kernel is done with. Returns -1 if the socket has
+///  an actual error.
+int32_t http_socket_zerocopy_complete(http_socket_t *socket) {
+  bool completed = false;
+
+  for (;;) {
+    uint8_t control[CMSG_SPACE(sizeof(struct sock_extended_err) +
+                               sizeof(struct sockaddr_in))];
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    if (recvmsg(socket->fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) == -1) {
+      if (errno == EINTR)
+        continue;
+      else if (errno == EAGAIN || errno == EWOULDBLOCK)
+        break;
+
+      perror("recvmsg (MSG_ERRQUEUE) failed");
+      return -1;
+    }
+
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL;
+         cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+      if (cmsg->cmsg_level != SOL_IP || cmsg->cmsg_type != IP_RECVERR)
+        continue;
+
+      // Anything else than a zero-copy completion is a real error.
+      struct sock_extended_err *err =
+          (struct sock_extended_err *)CMSG_DATA(cmsg);
+      if (err->ee_origin != SO_EE_ORIGIN_ZEROCOPY || err->ee_errno != 0)
+        return -1;
+
+      // A completion covers the range of ids from info up to data.
+      if (__http_socket_zerocopy_complete_range(socket, err->ee_info,
+                                                err->ee_data) != 0) {
+        fprintf(stderr, "Dropping zero-copy completion, out of memory.\r\n");
+        return -1;
+      }
+
+      completed = true;
+    }
   }
 
-  http_socket_write_op_free(&op);
+  __http_socket_zerocopy_release(socket);
 
-  --socket->n_pending_write_ops;
+  // If the error queue was empty, the error is on the socket itself.
+  if (!completed) {
+    int32_t error = 0;
+    socklen_t error_len = sizeof(error);
+    if (getsockopt(socket->fd, SOL_SOCKET, SO_ERROR, &error, &error_len) != 0 ||
+        error != 0)
+      return -1;
+  }
+
+  return 0;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -252,18 +778,25 @@ http_socket_t *http_socket_new(void) {
   if (res == NULL)
     return NULL;
 
-  // Allocates the receive buffer.
-  res->recv_buffer = (uint8_t *)malloc(HTTP_SOCKET_RECV_BUFFER_SIZE);
-  if (res->recv_buffer == NULL) {
-    free(res);
-    return NULL;
-  }
+  // The receive buffer is only taken from the pool once there is data.
+  res->recv_buffer = NULL;
+  res->recv_buffer_size = 0;
+
+  __http_socket_write_queue_init(res);
 
   // Creates the HTTP request instance, if this fails
   //  free and return NULL.
   res->request = http_request_create();
   if (res->request == NULL) {
-    free(res->recv_buffer);
+    free(res);
+
+    return NULL;
+  }
+
+  // Creates the HTTP response instance, which is reused for every request.
+  res->response = http_response_new();
+  if (res->response == NULL) {
+    http_request_free(&res->request);
     free(res);
 
     return NULL;
@@ -278,17 +811,25 @@ int32_t http_socket_free(http_socket_t **socket) {
   if (http_request_free(&((*socket)->request)) != 0)
     return -1;
 
+  // Frees the HTTP response.
+  if (http_response_free(&((*socket)->response)) != 0)
+    return -1;
+
   // Frees all the elements in the operation queue, for example
   //  freeing buffers, closing files etcetera.
-  http_socket_write_op_t *op = socket[0]->write_start;
-  while (op != NULL) {
-    http_socket_write_op_t *next = op->next;
-    http_socket_write_op_free(&op);
-    op = next;
-  }
+  __http_socket_write_queue_free(*socket);
 
-  // Frees the receive buffer.
+  // Frees the receive buffer, if the pool did not take it back, and the
+  //  output buffer.
   free((*socket)->recv_buffer);
+  free((*socket)->recv_backlog);
+  free((*socket)->output);
+
+  // The kernel keeps sending from zero-copy buffers after the close, and
+  //  their completions can no longer be read, so any retained ones are
+  //  leaked rather than handed back to malloc.
+  free((*socket)->zerocopy_buffers);
+  free((*socket)->zerocopy_ranges);
 
   // Frees the socket structure.
   free(*socket);
@@ -317,9 +858,24 @@ void __http_server_socket_log(http_server_socket_t *sock, const char *format,
   printf("\r\n");
 }
 
-/// Creates an new HTTP server socket instance.
+/// Gets the CPUs the process may run on, and returns how many there are.
+size_t __http_server_socket__allowed_cpus(cpu_set_t *set) {
+  CPU_ZERO(set);
+
+  if (sched_getaffinity(0, sizeof(cpu_set_t), set) != 0) {
+    perror("sched_getaffinity () failed");
+    return 0;
+  }
+
+  return (size_t)CPU_COUNT(set);
+}
+
+/// Creates an new HTTP server socket instance, the engine specifies which
+///  mechanism the socket pools use to wait for events, if the thread pool
+///  count is zero one pool per allowed CPU is created.
 http_server_socket_t *
 http_server_socket_create(size_t thread_pool_count, size_t max_socket_count,
+                          http_server_socket_pool_engine_t engine,
                           http_server_callback_t callback) {
   // Allocates the memory required for the server socket structure.
   http_server_socket_t *server_socket =
@@ -327,10 +883,20 @@ http_server_socket_create(size_t thread_pool_count, size_t max_socket_count,
   if (server_socket == NULL)
     return NULL;
 
+  // Gets the CPUs we may run on, these are handed out to the pools in order.
+  cpu_set_t cpus;
+  size_t cpu_count = __http_server_socket__allowed_cpus(&cpus);
+
+  if (thread_pool_count == 0)
+    thread_pool_count = cpu_count > 0 ? cpu_count : 1;
+
   // Sets the default values.
   server_socket->flags = 0;
   server_socket->thread_pool_count = thread_pool_count;
+  server_socket->engine = engine;
   server_socket->callback = callback;
+  server_socket->placement = HTTP_SERVER_SOCKET_PLACEMENT_ROUND_ROBIN;
+  server_socket->placement_random = 0x9E3779B9;
 
   // Allocates the memory for the socket pool-pointer array.
   server_socket->pools = (http_server_socket_pool_t **)malloc(
@@ -343,7 +909,7 @@ http_server_socket_create(size_t thread_pool_count, size_t max_socket_count,
   // Creates the socket pool instances.
   for (size_t i = 0; i < server_socket->thread_pool_count; ++i) {
     server_socket->pools[i] =
-        __http_server_socket_pool_create(max_socket_count);
+        __http_server_socket_pool_create(max_socket_count, engine);
     if (server_socket->pools[i] == NULL) {
       for (size_t j = 0; j < i; ++j)
         __http_server_socket_pool_free(&server_socket->pools[j]);
@@ -352,6 +918,16 @@ http_server_socket_create(size_t thread_pool_count, size_t max_socket_count,
     }
   }
 
+  // Assigns every pool a CPU, if there are more pools than CPUs we wrap
+  //  around. The pools are only pinned when requested.
+  for (size_t i = 0, cpu = 0; cpu_count > 0 && i < thread_pool_count; ++i) {
+    while (!CPU_ISSET(cpu % CPU_SETSIZE, &cpus))
+      cpu = (cpu + 1) % CPU_SETSIZE;
+
+    server_socket->pools[i]->cpu = (int32_t)cpu;
+    cpu = (cpu + 1) % CPU_SETSIZE;
+  }
+
   return server_socket;
 }
 
@@ -367,12 +943,6 @@ int32_t http_server_socket_init(http_server_socket_t *sock) {
 
 /// Frees an HTTP server socket instance.
 int32_t http_server_socket_free(http_server_socket_t **sock) {
-  // Destroys the acceptor mutex.
-  if (pthread_mutex_destroy(&(*sock)->acceptor_mutex) != 0) {
-    perror("pthread_mutex_destroy () failed");
-    return -1;
-  }
-
   // Frees all the individual pools.
   for (size_t i = 0; i < (*sock)->thread_pool_count; ++i)
     __http_server_socket_pool_free(&(*sock)->pools[i]);
@@ -422,8 +992,20 @@ int32_t http_server_socket_bind(http_server_socket_t *sock) {
   return 0;
 }
 
-/// Listens the specified HTTP server socket instance.
+/// Listens the specified HTTP server socket instance, when pool listeners are
+///  enabled every pool gets its own listening socket instead.
 int32_t http_server_socket_listen(http_server_socket_t *sock) {
+  // Checks if the pools should accept themselves, if so create their
+  //  listeners, the kernel will then spread the connections over them.
+  if (http_server_socket_flag_is_set(sock,
+                                     HTTP_SERVER_SOCKET_FLAG_POOL_LISTENERS)) {
+    for (size_t i = 0; i < sock->thread_pool_count; ++i)
+      if (__http_server_socket_pool_listen(sock, sock->pools[i]) != 0)
+        return -1;
+
+    return 0;
+  }
+
   if (listen(sock->fd, sock->backlog) < 0) {
     perror("listen () failed");
     return -1;
@@ -461,42 +1043,155 @@ int32_t http_server_socket_stop(http_server_socket_t *sock) {
 
 /// Creates new HTTP server socket pool.
 http_server_socket_pool_t *
-__http_server_socket_pool_create(size_t max_socket_count) {
+__http_server_socket_pool_create(size_t max_socket_count,
+                                 http_server_socket_pool_engine_t engine) {
   // Allocates the memory for the pool base structure.
   http_server_socket_pool_t *pool =
       (http_server_socket_pool_t *)calloc(1, sizeof(http_server_socket_pool_t));
   if (pool == NULL)
     return NULL;
 
-  // Allocates the memory for the poll fds.
-  struct pollfd *fds =
-      (struct pollfd *)calloc(max_socket_count, sizeof(struct pollfd));
-  if (fds == NULL) {
+  // Sets the pool variables.
+  pool->socket_count = 0;
+  pool->max_socket_count = max_socket_count;
+  pool->engine = engine;
+  pool->listen_fd = -1;
+  pool->cpu = -1;
+
+  // Allocates the fd-indexed socket table, which makes looking up the socket
+  //  of an event constant-time.
+  pool->sockets_by_fd_size = HTTP_SERVER_SOCKET_POOL_FD_TABLE_SIZE;
+  pool->sockets_by_fd =
+      (http_socket_t **)calloc(pool->sockets_by_fd_size, sizeof(http_socket_t *));
+  if (pool->sockets_by_fd == NULL) {
     free(pool);
     return NULL;
   }
 
-  // Sets the pool variables.
-  pool->fds = fds;
-  pool->socket_count = 0;
-  pool->max_socket_count = max_socket_count;
+  // Creates the queue through which the acceptor hands sockets to the pool,
+  //  and the eventfd it uses to wake the pool, this way only the pool thread
+  //  ever touches its own sockets.
+  if (http_mpsc_queue_init(&pool->incoming,
+                           HTTP_SERVER_SOCKET_POOL_INCOMING_QUEUE_SIZE,
+                           sizeof(http_server_socket_pool__incoming_t)) != 0) {
+    free(pool->sockets_by_fd);
+    free(pool);
+    return NULL;
+  }
+
+  if ((pool->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0) {
+    perror("eventfd () failed");
+    http_mpsc_queue_free(&pool->incoming);
+    free(pool->sockets_by_fd);
+    free(pool);
+    return NULL;
+  }
+
+  // Initializes the buffer pool, the receive buffers are taken from.
+  http_buffer_pool_init(&pool->buffers);
+
+  // Creates the timer wheel, which ticks at the wait timeout of the loop.
+  if (http_timer_wheel_init(&pool->timers, HTTP_SERVER_SOCKET_POOL_TIMER_SLOTS,
+                            HTTP_SERVER_SOCKET_POOL_WAIT_TIMEOUT) != 0) {
+    close(pool->wake_fd);
+    http_mpsc_queue_free(&pool->incoming);
+    free(pool->sockets_by_fd);
+    free(pool);
+    return NULL;
+  }
+
+  // Creates the engine specific resources, if io_uring is not available
+  //  (old kernel, seccomp etcetera) we will fall back to epoll.
+  if (pool->engine == HTTP_SERVER_SOCKET_POOL_ENGINE_IO_URING &&
+      __http_server_socket_pool_create__uring(pool) != 0) {
+    fprintf(stderr, "io_uring not available, falling back to epoll.\r\n");
+    pool->engine = HTTP_SERVER_SOCKET_POOL_ENGINE_EPOLL;
+  }
+
+  if (pool->engine == HTTP_SERVER_SOCKET_POOL_ENGINE_EPOLL &&
+      __http_server_socket_pool_create__epoll(pool) != 0) {
+    http_timer_wheel_free(&pool->timers);
+    close(pool->wake_fd);
+    http_mpsc_queue_free(&pool->incoming);
+    free(pool->sockets_by_fd);
+    free(pool);
+    return NULL;
+  }
 
   return pool;
 }
 
-/// Initializes HTTP server socket pool.
-int32_t __http_server_socket_pool_init(http_server_socket_pool_t *pool) {
-  // Initializes the mutex.
-  if (pthread_mutex_init(&pool->mutex, NULL) != 0) {
-    perror("pthread_mutex_init () failed");
+/// Creates the epoll instance of an HTTP server socket pool.
+int32_t
+__http_server_socket_pool_create__epoll(http_server_socket_pool_t *pool) {
+  // Allocates the memory for the epoll events, this is bounded by the
+  //  maximum number of events per wait, not by the number of sockets.
+  pool->events = (struct epoll_event *)calloc(
+      HTTP_SERVER_SOCKET_POOL_MAX_EVENTS, sizeof(struct epoll_event));
+  if (pool->events == NULL)
     return -1;
+
+  // Creates the epoll instance, to which all the sockets of this pool
+  //  will be registered once.
+  if ((pool->epoll_fd = epoll_create1(EPOLL_CLOEXEC)) < 0) {
+    perror("epoll_create1 () failed");
+    free(pool->events);
+    return -2;
+  }
+
+  // Registers the eventfd, so the acceptor can wake us up.
+  struct epoll_event event;
+  event.events = EPOLLIN;
+  event.data.fd = pool->wake_fd;
+
+  if (epoll_ctl(pool->epoll_fd, EPOLL_CTL_ADD, pool->wake_fd, &event) != 0) {
+    perror("epoll_ctl () failed");
+    close(pool->epoll_fd);
+    free(pool->events);
+    return -3;
   }
 
   return 0;
 }
 
-/// Starts HTTP server socket pool.
-int32_t __http_server_socket_pool_start(http_server_socket_t *sock,
+/// Creates the io_uring instance of an HTTP server socket pool.
+int32_t
+__http_server_socket_pool_create__uring(http_server_socket_pool_t *pool) {
+  // Creates the ring, and the buffers the multishot receives will use.
+  if (http_uring_init(&pool->ring, HTTP_SERVER_SOCKET_POOL_URING_ENTRIES) != 0)
+    return -1;
+
+  if (http_uring_setup_buffers(&pool->ring,
+                               HTTP_SERVER_SOCKET_POOL_URING_BUFFER_COUNT,
+                               HTTP_SERVER_SOCKET_POOL_URING_BUFFER_SIZE) !=
+      0) {
+    http_uring_free(&pool->ring);
+    return -2;
+  }
+
+  // Posts the multishot poll for the eventfd, which the acceptor uses to
+  //  tell us there are new sockets in the incoming queue.
+  struct io_uring_sqe *sqe = http_uring_get_sqe(&pool->ring);
+  http_uring_prep_poll(
+      sqe, pool->wake_fd, POLLIN, true,
+      __HTTP_SOCKET_POOL_URING_USER_DATA(HTTP_SOCKET_POOL_URING_OP_WAKE, 0, 0));
+
+  return 0;
+}
+
+/// Initializes HTTP server socket pool.
+int32_t __http_server_socket_pool_init(http_server_socket_pool_t *pool) {
+  // Initializes the mutex.
+  if (pthread_mutex_init(&pool->mutex, NULL) != 0) {
+    perror("pthread_mutex_init () failed");
+    return -1;
+  }
+
+  return 0;
+}
+
+/// Starts HTTP server socket pool.
+int32_t __http_server_socket_pool_start(http_server_socket_t *sock,
                                         http_server_socket_pool_t *pool) {
   // Creates the thead argument, containing socket and pool.
   __http_socket_pool_method__arg *arg =
@@ -508,11 +1203,96 @@ int32_t __http_server_socket_pool_start(http_server_socket_t *sock,
   arg->pool = pool;
   arg->sock = sock;
 
+  // Pins the thread to the CPU of the pool, setting it in the attributes
+  //  makes sure the thread never runs anywhere else, not even briefly.
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+
+  if (http_server_socket_flag_is_set(sock, HTTP_SERVER_SOCKET_FLAG_PIN_POOLS) &&
+      pool->cpu >= 0) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(pool->cpu, &cpus);
+
+    if (pthread_attr_setaffinity_np(&attr, sizeof(cpu_set_t), &cpus) != 0)
+      fprintf(stderr, "pthread_attr_setaffinity_np () failed.\r\n");
+    else
+      pool->flags |= HTTP_SERVER_SOCKET_POOL_FLAG_PINNED;
+  }
+
+  if (http_server_socket_flag_is_set(sock, HTTP_SERVER_SOCKET_FLAG_ZEROCOPY))
+    pool->zerocopy = true;
+
   // Starts the threada.
-  if (pthread_create(&pool->thread, NULL, __http_socket_pool_method,
+  if (pthread_create(&pool->thread, &attr, __http_socket_pool_method,
                      (void *)arg) != 0) {
     perror("pthread_create () failed");
+    pthread_attr_destroy(&attr);
+    free(arg);
+    return -2;
+  }
+
+  pthread_attr_destroy(&attr);
+  return 0;
+}
+
+/// Creates the SO_REUSEPORT listening socket of a pool, and registers it to
+///  the engine of the pool so it accepts inside its own event loop.
+int32_t __http_server_socket_pool_listen(http_server_socket_t *sock,
+                                         http_server_socket_pool_t *pool) {
+  if ((pool->listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK |
+                                             SOCK_CLOEXEC,
+                                IPPROTO_TCP)) < 0) {
+    perror("socket () failed");
+    return -1;
+  }
+
+  // Sets the socket reuse port and reuse address, the reuse port is what
+  //  allows all the pools to bind to the same address.
+  int reuse = 1;
+  if (setsockopt(pool->listen_fd, SOL_SOCKET, SO_REUSEADDR,
+                 (const char *)&reuse, sizeof(reuse)) < 0) {
+    perror("setsockopt (SOL_SOCKET, SO_REUSEADDR) failed");
     return -2;
+  } else if (setsockopt(pool->listen_fd, SOL_SOCKET, SO_REUSEPORT,
+                        (const char *)&reuse, sizeof(reuse)) < 0) {
+    perror("setsockopt (SOL_SOCKET, SO_REUSEPORT) failed");
+    return -3;
+  }
+
+  // Binds and listens on the address of the server socket.
+  if (bind(pool->listen_fd, (struct sockaddr *)&sock->address,
+           sizeof(struct sockaddr_in)) < 0) {
+    perror("bind () failed");
+    return -4;
+  } else if (listen(pool->listen_fd, sock->backlog) < 0) {
+    perror("listen () failed");
+    return -5;
+  }
+
+  // Registers the listener to the engine, the pool thread is not running
+  //  yet, so we're still allowed to touch the submission queue.
+  switch (pool->engine) {
+  case HTTP_SERVER_SOCKET_POOL_ENGINE_EPOLL: {
+    // The listener is level-triggered, since we accept in batches and want
+    //  to be notified again if there is anything left.
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.fd = pool->listen_fd;
+    if (epoll_ctl(pool->epoll_fd, EPOLL_CTL_ADD, pool->listen_fd, &event) !=
+        0) {
+      perror("epoll_ctl (EPOLL_CTL_ADD) failed");
+      return -6;
+    }
+
+    break;
+  }
+  case HTTP_SERVER_SOCKET_POOL_ENGINE_IO_URING:
+    if (__http_socket_pool__uring_arm_accept(pool) != 0)
+      return -6;
+    break;
+  default:
+    break;
   }
 
   return 0;
@@ -525,6 +1305,10 @@ int32_t __http_server_socket_pool_stop(http_server_socket_pool_t *pool) {
   pool->flags |= HTTP_SERVER_SOCKET_POOL_FLAG_SHUTDOWN;
   pthread_mutex_unlock(&pool->mutex);
 
+  // Wakes the pool, so it does not have to wait for the timeout.
+  if (eventfd_write(pool->wake_fd, 1) != 0)
+    perror("eventfd_write () failed");
+
   // Joins the socket pool with the current thread, waiting for it to shutdown.
   if (pthread_join(pool->thread, NULL) != 0) {
     perror("pthread_join () failed");
@@ -545,46 +1329,282 @@ int32_t __http_server_socket_pool_stop(http_server_socket_pool_t *pool) {
     socket = next;
   }
 
+  // Closes the connections which were handed over, but never registered.
+  http_server_socket_pool__incoming_t conn;
+  while (http_mpsc_queue_pop(&pool->incoming, &conn)) {
+    __atomic_sub_fetch(&pool->load.connections, 1, __ATOMIC_RELAXED);
+    close(conn.fd);
+  }
+
   return 0;
 }
 
 /// Frees HTTP server socket pool.
 void __http_server_socket_pool_free(http_server_socket_pool_t **pool) {
-  // Frees the fds struct array.
-  free((*pool)->fds);
+  // Closes the pool listener, if there is any.
+  if ((*pool)->listen_fd >= 0 && close((*pool)->listen_fd) != 0)
+    perror("close () failed");
+
+  // Frees the engine specific resources.
+  switch ((*pool)->engine) {
+  case HTTP_SERVER_SOCKET_POOL_ENGINE_EPOLL:
+    if (close((*pool)->epoll_fd) != 0)
+      perror("close () failed");
+
+    free((*pool)->events);
+    break;
+  case HTTP_SERVER_SOCKET_POOL_ENGINE_IO_URING:
+    http_uring_free(&(*pool)->ring);
+    break;
+  default:
+    break;
+  }
+
+  // Frees the incoming queue and its eventfd.
+  if (close((*pool)->wake_fd) != 0)
+    perror("close () failed");
+
+  http_mpsc_queue_free(&(*pool)->incoming);
+
+  // Frees the timer wheel, and the cached buffers.
+  http_timer_wheel_free(&(*pool)->timers);
+  http_buffer_pool_free(&(*pool)->buffers);
+
+  // Frees the socket slabs, including the requests and responses they kept
+  //  around.
+  while ((*pool)->slabs != NULL) {
+    http_socket_slab_t *next = (*pool)->slabs->next;
+
+    for (size_t i = 0; i < HTTP_SERVER_SOCKET_POOL_SLAB_SIZE; ++i) {
+      http_socket_t *socket = &(*pool)->slabs->sockets[i];
+
+      if (socket->request != NULL)
+        http_request_free(&socket->request);
+      if (socket->response != NULL)
+        http_response_free(&socket->response);
+      free(socket->recv_buffer);
+      free(socket->output);
+      free(socket->zerocopy_buffers);
+      free(socket->zerocopy_ranges);
+      if (socket->write_ops_capacity > HTTP_SOCKET_WRITE_QUEUE_INLINE_SIZE)
+        free(socket->write_ops);
+    }
+
+    free((*pool)->slabs);
+    (*pool)->slabs = next;
+  }
+
+  // Frees the socket table.
+  free((*pool)->sockets_by_fd);
 
   // Frees the structure, and sets it to zero.
   free(*pool);
   *pool = NULL;
 }
 
+/// Takes a socket from the free list of the pool, allocates a new slab when
+///  the free list is empty. The socket comes with a reset request.
+http_socket_t *
+__http_socket_pool__alloc_socket(http_server_socket_pool_t *pool) {
+  if (pool->free_sockets == NULL) {
+    http_socket_slab_t *slab =
+        (http_socket_slab_t *)calloc(1, sizeof(http_socket_slab_t));
+    if (slab == NULL)
+      return NULL;
+
+    // Creates the requests and responses once, these stay with the sockets
+    //  while they go through the free list.
+    for (size_t i = 0; i < HTTP_SERVER_SOCKET_POOL_SLAB_SIZE; ++i) {
+      http_socket_t *socket = &slab->sockets[i];
+
+      if ((socket->request = http_request_create()) == NULL)
+        break;
+      if ((socket->response = http_response_new()) == NULL) {
+        http_request_free(&socket->request);
+        break;
+      }
+
+      socket->next = pool->free_sockets;
+      pool->free_sockets = socket;
+    }
+
+    slab->next = pool->slabs;
+    pool->slabs = slab;
+
+    if (pool->free_sockets == NULL)
+      return NULL;
+  }
+
+  http_socket_t *socket = pool->free_sockets;
+  pool->free_sockets = socket->next;
+
+  // Clears everything from the previous connection, except the request,
+  //  response, output buffer, write queue and zero-copy lists.
+  http_request_t *request = socket->request;
+  http_response_t *response = socket->response;
+  uint8_t *output = socket->output;
+  size_t output_size = socket->output_size;
+  http_socket_write_op_t *write_ops = socket->write_ops;
+  size_t write_ops_capacity = socket->write_ops_capacity;
+  http_socket_zerocopy_buffer_t *zerocopy_buffers = socket->zerocopy_buffers;
+  size_t zerocopy_capacity = socket->zerocopy_capacity;
+  http_socket_zerocopy_range_t *zerocopy_ranges = socket->zerocopy_ranges;
+  size_t zerocopy_ranges_capacity = socket->zerocopy_ranges_capacity;
+  memset(socket, 0, sizeof(http_socket_t));
+  socket->request = request;
+  socket->response = response;
+  socket->output = output;
+  socket->output_size = output_size;
+  socket->write_ops = write_ops;
+  socket->write_ops_capacity = write_ops_capacity;
+  socket->zerocopy_buffers = zerocopy_buffers;
+  socket->zerocopy_capacity = zerocopy_capacity;
+  socket->zerocopy_ranges = zerocopy_ranges;
+  socket->zerocopy_ranges_capacity = zerocopy_ranges_capacity;
+
+  __http_socket_write_queue_init(socket);
+
+  return socket;
+}
+
+/// Gives a socket back to the free list of the pool.
+void __http_socket_pool__release_socket(http_server_socket_pool_t *pool,
+                                        http_socket_t *socket) {
+  // Frees all the elements in the operation queue, for example freeing
+  //  buffers, closing files etcetera, the queue itself is kept.
+  while (socket->n_pending_write_ops > 0)
+    http_socket_dequeue_write_op(socket);
+
+  socket->output_level = 0;
+
+  free(socket->recv_backlog);
+  socket->recv_backlog = NULL;
+  socket->recv_backlog_size = 0;
+
+  // Zero-copy buffers are not freed here, a closing socket lingers until the
+  //  kernel completed them. Only when the pool stops, sockets are closed with
+  //  buffers still retained, those are leaked since the kernel may still be
+  //  sending from them.
+
+  http_request_reset(socket->request);
+  http_response_reset(socket->response);
+
+  socket->next = pool->free_sockets;
+  pool->free_sockets = socket;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
-/// Gets called when an socket can be written to.
+/// Gets called when an socket can be written to, it writes until the socket
+///  buffer is full, or the write budget of this iteration is spent. In the
+///  latter case the socket continues from the ready list, after the others.
 int32_t __http_socket_pool__on_writable(http_server_socket_t *sock,
                                         http_server_socket_pool_t *pool,
                                         http_socket_t *socket) {
+  size_t start = socket->bytes_sent;
   int32_t rc;
+
   while (socket->n_pending_write_ops > 0) {
-    http_socket_write_op_t *op = socket->write_end;
+    size_t spent = socket->bytes_sent - start;
+    if (spent >= HTTP_SOCKET_WRITE_BUDGET) {
+      __http_socket_pool__ready_push(pool, socket);
+      break;
+    }
 
-    if ((rc = http_socket_write_op_write(socket, op) != 0) < 0) {
-      return -1;
-    } else if (rc == 1) {
+    http_socket_write_op_t *op = http_socket_write_queue_front(socket);
+
+    // Byte operations are sent together, and dequeue themselves, except the
+    //  zero-copy ones which are sent on their own.
+    if (op->op == HTTP_SOCKET_WRITE_OP_BYTES &&
+        !__http_socket_write_op_is_zerocopy(socket, op))
+      rc = __http_socket_write_op_write__gather(
+          socket, HTTP_SOCKET_WRITE_BUDGET - spent);
+    else if ((rc = http_socket_write_op_write(
+                  socket, op, HTTP_SOCKET_WRITE_BUDGET - spent)) ==
+             HTTP_SOCKET_WRITE_OP_DONE)
       http_socket_dequeue_write_op(socket);
-    }
+
+    // If the socket buffer is full, we wait until it becomes writable again.
+    if (rc < 0)
+      return -1;
+    else if (rc == HTTP_SOCKET_WRITE_OP_BLOCKED)
+      break;
   }
 
-  return 0;
+  return __http_socket_pool__unthrottle(sock, pool, socket);
+}
+
+/// Appends a socket to the ready list of the pool, these still have data to
+///  write, and are writable, but have spent their write budget.
+void __http_socket_pool__ready_push(http_server_socket_pool_t *pool,
+                                    http_socket_t *socket) {
+  if (socket->flags & HTTP_SOCKET_FLAG_WRITE_READY)
+    return;
+
+  socket->flags |= HTTP_SOCKET_FLAG_WRITE_READY;
+  socket->ready_next = NULL;
+  socket->ready_prev = pool->ready_end;
+
+  if (pool->ready_end != NULL)
+    pool->ready_end->ready_next = socket;
+  else
+    pool->ready_start = socket;
+
+  pool->ready_end = socket;
+}
+
+/// Removes a socket from the ready list of the pool, if it is on there.
+void __http_socket_pool__ready_remove(http_server_socket_pool_t *pool,
+                                      http_socket_t *socket) {
+  if (!(socket->flags & HTTP_SOCKET_FLAG_WRITE_READY))
+    return;
+
+  if (socket->ready_prev != NULL)
+    socket->ready_prev->ready_next = socket->ready_next;
+  else
+    pool->ready_start = socket->ready_next;
+
+  if (socket->ready_next != NULL)
+    socket->ready_next->ready_prev = socket->ready_prev;
+  else
+    pool->ready_end = socket->ready_prev;
+
+  socket->ready_next = socket->ready_prev = NULL;
+  socket->flags &= ~HTTP_SOCKET_FLAG_WRITE_READY;
+}
+
+/// Gives every socket on the ready list another write budget, in the order
+///  they ran out of it. The ones which spend it again go to the back.
+void __http_socket_pool__flush_ready(http_server_socket_t *sock,
+                                     http_server_socket_pool_t *pool) {
+  // Only serves the sockets which are on the list right now, so a socket
+  //  which is pushed again waits for the next iteration.
+  http_socket_t *end = pool->ready_end;
+
+  while (pool->ready_start != NULL) {
+    http_socket_t *socket = pool->ready_start;
+    __http_socket_pool__ready_remove(pool, socket);
+
+    if (__http_socket_pool__on_writable(sock, pool, socket) != 0 ||
+        __http_socket_pool__update_events(pool, socket) != 0)
+      __http_socket_pool__close_socket(pool, socket);
+
+    if (socket == end)
+      break;
+  }
 }
 
 /// Processes the request body line-wise, this is done for headers and type.
+///  The head stays in the receive buffer until the request is done, since the
+///  request refers to it, so only the lines after the parsed ones are read.
 int32_t
 __http_socket_pool__on_readable__process_lines(http_server_socket_t *sock,
                                                http_server_socket_pool_t *pool,
                                                http_socket_t *socket) {
-  size_t offset = 0;
+  http_request_t *request = socket->request;
+
   for (;;) {
+    size_t offset = request->head_len;
     uint8_t *start = &socket->recv_buffer[offset];
     uint8_t *lf =
         memchr((const void *)start, '\n', socket->recv_buffer_level - offset);
@@ -592,30 +1612,21 @@ __http_socket_pool__on_readable__process_lines(http_server_socket_t *sock,
       break;
     }
 
+    // Passes the line without its terminator.
     size_t line_len = lf - start;
-    if (line_len > 1) {
-      lf[lf[-1] == '\r' ? -1 : 0] = '\0';
+    size_t len = line_len > 0 && lf[-1] == '\r' ? line_len - 1 : line_len;
 
-      http_request_update(socket->request, start);
-    } else {
-      http_request_update(socket->request, (uint8_t *)"");
-    }
+    if (http_request_update(request, socket->recv_buffer, offset, len) != 0)
+      return -1;
 
-    offset += line_len + 1;
+    request->head_len += line_len + 1;
 
-    if (http_request_get_state(socket->request) ==
-            HTTP_REQUEST_STATE_RECEIVING_BODY ||
-        http_request_get_state(socket->request) == HTTP_REQUEST_STATE_DONE) {
+    if (http_request_get_state(request) == HTTP_REQUEST_STATE_RECEIVING_BODY ||
+        http_request_get_state(request) == HTTP_REQUEST_STATE_DONE) {
       break;
     }
   }
 
-  // Moves the buffer so we can read more in the future.
-  memmove(socket->recv_buffer, &socket->recv_buffer[offset],
-          socket->recv_buffer_level - offset);
-  socket->recv_buffer[socket->recv_buffer_level - offset] = '\0';
-  socket->recv_buffer_level -= offset;
-
   return 0;
 }
 
@@ -624,30 +1635,37 @@ int32_t
 __http_socket_pool__on_readable__process_binary(http_server_socket_t *sock,
                                                 http_server_socket_pool_t *pool,
                                                 http_socket_t *socket) {
-  size_t size = socket->recv_buffer_level;
-  if (size >= socket->request->expected_body_size) {
-    size = socket->request->expected_body_size;
-  }
-
-  printf("%s: %lu\r\n", socket->recv_buffer, size);
+  // Only takes the bytes which belong to this body, anything after it is
+  //  the next (pipelined) request. The body follows the head.
+  size_t head_len = socket->request->head_len;
+  size_t size = socket->recv_buffer_level - head_len;
+  size_t remaining =
+      socket->request->expected_body_size - socket->request->received_body_size;
+  if (size > remaining)
+    size = remaining;
+
+  if (size == 0)
+    return 0;
 
-  // Allocates the memory required for the segment.
-  uint8_t *segment = (uint8_t *)malloc(size);
+  // Takes a segment, this reuses the memory of the previous request bodies.
+  http_segmented_buffer__segment_t *segment =
+      http_segmented_buffer_take_segment(socket->request->body, size);
   if (segment == NULL)
     return -1;
 
-  memcpy(segment, socket->recv_buffer, size);
+  memcpy(segment->bytes, &socket->recv_buffer[head_len], size);
 
   // Appends the new segment the segmented buffer.
-  if (http_segmented_buffer_append(
-          socket->request->body,
-          http_segmented_buffer_segment_create(segment, size)) != 0)
+  if (http_segmented_buffer_append(socket->request->body, segment) != 0)
     return -2;
 
-  // Trims the buffer, and removes the read bytes from the buffer level.
-  memmove(socket->recv_buffer, &socket->recv_buffer[size - 1], size);
+  // Trims the buffer, and removes the read bytes from the buffer level, the
+  //  head is kept.
+  memmove(&socket->recv_buffer[head_len], &socket->recv_buffer[head_len + size],
+          socket->recv_buffer_level - head_len - size);
 
   socket->recv_buffer_level -= size;
+  socket->recv_buffer[socket->recv_buffer_level] = '\0';
   socket->request->received_body_size += size;
 
   // Checks if we're done receiving the body, if so we're going to update the
@@ -660,53 +1678,131 @@ __http_socket_pool__on_readable__process_binary(http_server_socket_t *sock,
   return 0;
 }
 
-/// Gets called when an socket can be read from.
-int32_t __http_socket_pool__on_readable(http_server_socket_t *sock,
-                                        http_server_socket_pool_t *pool,
-                                        http_socket_t *socket) {
-  int rc = recv(socket->fd, &socket->recv_buffer[socket->recv_buffer_level],
-                HTTP_SOCKET_RECV_BUFFER_SIZE - socket->recv_buffer_level, 0);
-  switch (rc) {
-  case 0:
+/// Stops handling the requests of a socket while its responses pile up, with
+///  io_uring its receive is cancelled as well.
+int32_t __http_socket_pool__throttle(http_server_socket_pool_t *pool,
+                                     http_socket_t *socket) {
+  socket->flags |= HTTP_SOCKET_FLAG_THROTTLED;
+
+  // The epoll engine simply stops reading, the multishot receive would keep
+  //  posting data, so it's cancelled and posted again once we resume.
+  if (pool->engine != HTTP_SERVER_SOCKET_POOL_ENGINE_IO_URING ||
+      (socket->flags &
+       (HTTP_SOCKET_FLAG_URING_RECV_CANCEL | HTTP_SOCKET_FLAG_URING_RECV_IDLE)))
+    return 0;
+
+  struct io_uring_sqe *sqe = http_uring_get_sqe(&pool->ring);
+  if (sqe == NULL)
     return -1;
-  case -1:
-    if (errno != ECONNRESET)
-      perror("recv () failed");
-    return -2;
-  default:
-    break;
-  }
 
-  // Adds the received bytes to the receive buffer level.
-  socket->recv_buffer_level += (size_t)rc;
+  http_uring_prep_cancel(
+      sqe,
+      __HTTP_SOCKET_POOL_URING_USER_DATA(HTTP_SOCKET_POOL_URING_OP_RECV,
+                                         socket->generation, socket->fd),
+      __HTTP_SOCKET_POOL_URING_USER_DATA(HTTP_SOCKET_POOL_URING_OP_CANCEL,
+                                         socket->generation, socket->fd));
+  socket->flags |= HTTP_SOCKET_FLAG_URING_RECV_CANCEL;
 
-  // Checks if we're dealing with binary or text-like data, this might actually
-  //  read the complete headers, and that's why we next check if we're
-  //  receiving the body.
-  if (http_request_get_state(socket->request) !=
-      HTTP_REQUEST_STATE_RECEIVING_BODY)
-    if (__http_socket_pool__on_readable__process_lines(sock, pool, socket) != 0)
-      return -1;
+  return 0;
+}
 
-  // Checks if we're supposed to now read binary data, for example the body.
-  //  We're doing this in a separate if, since the process lines might
-  //  have modified the way we should treat the data.
-  if (http_request_get_state(socket->request) ==
-      HTTP_REQUEST_STATE_RECEIVING_BODY)
-    if (__http_socket_pool__on_readable__process_binary(sock, pool, socket) !=
-        0)
+/// Resumes a throttled socket once its queued output dropped below the
+///  limit, handles the requests it already received and continues reading.
+int32_t __http_socket_pool__unthrottle(http_server_socket_t *sock,
+                                       http_server_socket_pool_t *pool,
+                                       http_socket_t *socket) {
+  if (!(socket->flags & HTTP_SOCKET_FLAG_THROTTLED) ||
+      socket->write_bytes_pending >= HTTP_SOCKET_PIPELINE_MAX_PENDING)
+    return 0;
+
+  socket->flags &= ~HTTP_SOCKET_FLAG_THROTTLED;
+
+  if (socket->recv_buffer_level > 0 &&
+      __http_socket_pool__on_readable__process(sock, pool, socket) != 0)
+    return -1;
+
+  // The requests which were waiting may have filled the output again.
+  if (socket->flags & HTTP_SOCKET_FLAG_THROTTLED)
+    return 0;
+
+  // Since we're edge-triggered, there won't be another event for the data
+  //  we left in the socket, so read it now.
+  if (pool->engine != HTTP_SERVER_SOCKET_POOL_ENGINE_IO_URING)
+    return __http_socket_pool__on_readable(sock, pool, socket);
+
+  // Continues with what io_uring received while we were throttled.
+  if (socket->recv_backlog != NULL) {
+    uint8_t *backlog = socket->recv_backlog;
+    size_t backlog_size = socket->recv_backlog_size;
+    socket->recv_backlog = NULL;
+    socket->recv_backlog_size = 0;
+
+    int32_t rc = __http_socket_pool__uring_receive(sock, pool, socket, backlog,
+                                                   backlog_size);
+    free(backlog);
+
+    if (rc != 0)
       return -1;
+    else if (socket->flags & HTTP_SOCKET_FLAG_THROTTLED)
+      return 0;
+  }
+
+  __http_socket_pool__release_recv_buffer(pool, socket);
+
+  if (!(socket->flags & HTTP_SOCKET_FLAG_URING_RECV_IDLE))
+    return 0;
+
+  socket->flags &= ~HTTP_SOCKET_FLAG_URING_RECV_IDLE;
+  return __http_socket_pool__uring_arm_recv(pool, socket);
+}
+
+/// Processes the data inside of the receive buffer.
+int32_t __http_socket_pool__on_readable__process(http_server_socket_t *sock,
+                                                 http_server_socket_pool_t *pool,
+                                                 http_socket_t *socket) {
+  // Keeps going as long as the buffer holds complete requests, so pipelined
+  //  requests get dispatched right away, instead of waiting for more data.
+  //  The callbacks queue their responses in the order of the requests.
+  for (;;) {
+    // Stops while the responses pile up, a client which pipelines requests
+    //  without reading the responses would otherwise make the write queue
+    //  and the output buffer grow without bound. Writing resumes it.
+    if (socket->flags & HTTP_SOCKET_FLAG_THROTTLED)
+      break;
+    else if (socket->write_bytes_pending >= HTTP_SOCKET_PIPELINE_MAX_PENDING) {
+      if (__http_socket_pool__throttle(pool, socket) != 0)
+        return -1;
+      break;
+    }
+
+    // Checks if we're dealing with binary or text-like data, this might
+    //  actually read the complete headers, and that's why we next check if
+    //  we're receiving the body.
+    if (http_request_get_state(socket->request) !=
+        HTTP_REQUEST_STATE_RECEIVING_BODY)
+      if (__http_socket_pool__on_readable__process_lines(sock, pool, socket) !=
+          0)
+        return -1;
+
+    // Checks if we're supposed to now read binary data, for example the body.
+    //  We're doing this in a separate if, since the process lines might
+    //  have modified the way we should treat the data.
+    if (http_request_get_state(socket->request) ==
+        HTTP_REQUEST_STATE_RECEIVING_BODY)
+      if (__http_socket_pool__on_readable__process_binary(sock, pool,
+                                                          socket) != 0)
+        return -1;
+
+    // Checks if the request is done, if not we need more data.
+    if (http_request_get_state(socket->request) != HTTP_REQUEST_STATE_DONE)
+      break;
 
-  // Checks if the request is done, if so call the request done callback, so
-  //  the unser functions can perform the response.
-  if (http_request_get_state(socket->request) == HTTP_REQUEST_STATE_DONE) {
     // Prints the request headers.
     // http_request_print (socket->request);
 
-    // Creates the response.
-    http_response_t *response = http_response_new();
-    if (response == NULL)
-      return -1;
+    // Resets the response of the connection, instead of creating a new one.
+    http_response_t *response = socket->response;
+    http_response_reset(response);
 
     // Sets the default response values.
     http_response_set_method(response,
@@ -714,23 +1810,121 @@ int32_t __http_socket_pool__on_readable(http_server_socket_t *sock,
     http_response_set_version(response,
                               http_request_get_version(socket->request));
 
-    // Calls the callback.
+    // Calls the callback, the receive buffer may have moved since the head
+    //  has been parsed.
+    socket->request->buffer = socket->recv_buffer;
     sock->callback(socket, socket->request, response);
 
-    // Frees the response
-    if (http_response_free(&response) != 0)
-      return -1;
+    // Removes the head from the buffer, and resets the request, so it can
+    //  receive the next one.
+    size_t head_len = socket->request->head_len;
+    memmove(socket->recv_buffer, &socket->recv_buffer[head_len],
+            socket->recv_buffer_level - head_len);
+    socket->recv_buffer_level -= head_len;
+    socket->recv_buffer[socket->recv_buffer_level] = '\0';
 
-    // Resets the request.
-    if (http_request_free(&socket->request) != 0)
-      return -1;
-    else if ((socket->request = http_request_create()) == 0)
-      return -1;
+    http_request_reset(socket->request);
+
+    // If there is nothing left in the buffer, there is no next request.
+    if (socket->recv_buffer_level == 0)
+      break;
+  }
+
+  return 0;
+}
+
+/// Makes sure the socket has a receive buffer with free space, takes one from
+///  the pool or grows it, returns -1 if it's full at the largest size.
+int32_t __http_socket_pool__reserve_recv_buffer(http_server_socket_pool_t *pool,
+                                                http_socket_t *socket) {
+  // Checks if there is any space left, one byte is reserved for the
+  //  NULL-termination of the lines.
+  if (socket->recv_buffer != NULL &&
+      socket->recv_buffer_level < socket->recv_buffer_size - 1)
+    return 0;
+
+  // Takes a buffer of the next size class, since the data in the buffer is
+  //  an incomplete request head, or the few requests io_uring received
+  //  while the socket got throttled, that's the only way it fits.
+  size_t size;
+  uint8_t *buffer = http_buffer_pool_get(
+      &pool->buffers,
+      socket->recv_buffer == NULL ? HTTP_SOCKET_RECV_BUFFER_SIZE
+                                  : socket->recv_buffer_size + 1,
+      &size);
+  if (buffer == NULL)
+    return -1;
+
+  if (socket->recv_buffer != NULL) {
+    memcpy(buffer, socket->recv_buffer, socket->recv_buffer_level);
+    http_buffer_pool_put(&pool->buffers, socket->recv_buffer,
+                         socket->recv_buffer_size);
   }
 
+  socket->recv_buffer = buffer;
+  socket->recv_buffer_size = size;
+
   return 0;
 }
 
+/// Gives the receive buffer of the socket back to the pool, if it's empty.
+void __http_socket_pool__release_recv_buffer(http_server_socket_pool_t *pool,
+                                             http_socket_t *socket) {
+  if (socket->recv_buffer == NULL || socket->recv_buffer_level != 0)
+    return;
+
+  http_buffer_pool_put(&pool->buffers, socket->recv_buffer,
+                       socket->recv_buffer_size);
+  socket->recv_buffer = NULL;
+  socket->recv_buffer_size = 0;
+}
+
+/// Gets called when an socket can be read from, reads until EAGAIN since the
+///  sockets are registered edge-triggered.
+int32_t __http_socket_pool__on_readable(http_server_socket_t *sock,
+                                        http_server_socket_pool_t *pool,
+                                        http_socket_t *socket) {
+  for (;;) {
+    // A throttled socket leaves the data in the kernel, until it resumes.
+    if (socket->flags & HTTP_SOCKET_FLAG_THROTTLED)
+      return 0;
+
+    // Makes sure there is space left in the receive buffer, one byte is
+    //  reserved for the NULL-termination of the lines.
+    if (__http_socket_pool__reserve_recv_buffer(pool, socket) != 0)
+      return -3;
+
+    int rc = recv(socket->fd, &socket->recv_buffer[socket->recv_buffer_level],
+                  socket->recv_buffer_size - 1 - socket->recv_buffer_level, 0);
+    switch (rc) {
+    case 0:
+      return -1;
+    case -1:
+      // Since we're edge-triggered, EAGAIN means we've drained the socket
+      //  and will be notified again once new data arrives, until then the
+      //  buffer is not needed if it's empty.
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        __http_socket_pool__release_recv_buffer(pool, socket);
+        return 0;
+      }
+      else if (errno == EINTR)
+        continue;
+      else if (errno != ECONNRESET)
+        perror("recv () failed");
+      return -2;
+    default:
+      break;
+    }
+
+    // Adds the received bytes to the receive buffer level.
+    socket->recv_buffer_level += (size_t)rc;
+
+    // Processes the received data.
+    if (__http_socket_pool__on_readable__process(sock, pool, socket) != 0)
+      return -1;
+  }
+}
+
 /// Registers an socket to specified pool, only can be called if pool empty.
 void __http_socket_pool_register_socket__empty_pool(
     http_server_socket_pool_t *pool, http_socket_t *socket) {
@@ -763,13 +1957,239 @@ void __http_socket_pool_register_socket__not_empty_pool(
   ++pool->socket_count;
 }
 
-/// Registers an socket to the specified pool
-void __http_socket_pool_register_socket(http_server_socket_pool_t *pool,
-                                        http_socket_t *socket) {
+/// Registers an socket to the specified pool, and adds it to the epoll
+///  instance, returns -1 if the pool is full.
+int32_t __http_socket_pool_register_socket(http_server_socket_pool_t *pool,
+                                           http_socket_t *socket) {
+  if (pool->socket_count >= pool->max_socket_count)
+    return -1;
+  else if (__http_socket_pool__reserve_fd(pool, socket->fd) != 0)
+    return -1;
+
+  // Gives the socket a new generation, so stale completions of a previous
+  //  socket with the same fd can be recognized.
+  socket->generation = ++pool->generation;
+
+  switch (pool->engine) {
+  case HTTP_SERVER_SOCKET_POOL_ENGINE_EPOLL: {
+    // Registers the socket edge-triggered for reading and writing at once,
+    //  EPOLLOUT is only reported when a full send buffer drains, so the
+    //  interest never has to be modified for a response.
+    struct epoll_event event;
+    event.events = EPOLLIN | EPOLLOUT | EPOLLET;
+    event.data.fd = socket->fd;
+    if (epoll_ctl(pool->epoll_fd, EPOLL_CTL_ADD, socket->fd, &event) != 0) {
+      perror("epoll_ctl (EPOLL_CTL_ADD) failed");
+      return -2;
+    }
+
+    break;
+  }
+  case HTTP_SERVER_SOCKET_POOL_ENGINE_IO_URING:
+    // The multishot receive is posted by the pool thread, since it's the only
+    //  one allowed to submit.
+    break;
+  default:
+    return -3;
+  }
+
   if (pool->socket_count == 0)
     __http_socket_pool_register_socket__empty_pool(pool, socket);
   else
     __http_socket_pool_register_socket__not_empty_pool(pool, socket);
+
+  pool->sockets_by_fd[socket->fd] = socket;
+
+  return 0;
+}
+
+/// Updates the socket after its events, publishes its writes and timeout, and
+///  with io_uring posts the polls it needs. The epoll interest never changes.
+int32_t __http_socket_pool__update_events(http_server_socket_pool_t *pool,
+                                          http_socket_t *socket) {
+  bool want_out = socket->n_pending_write_ops > 0;
+
+  // This is called after every event of the socket, so publish the writes it
+  //  queued or finished to the load of the pool, and update its timeout.
+  __http_socket_pool__account_writes(pool, socket);
+  __http_socket_pool__update_timer(pool, socket);
+
+  // The io_uring engine uses one-shot polls, which we only post when there
+  //  is something to write and no poll is already in flight, sockets on the
+  //  ready list are known to be writable already.
+  if (pool->engine == HTTP_SERVER_SOCKET_POOL_ENGINE_IO_URING) {
+    // While the kernel still holds zero-copy buffers, an error queue poll
+    //  makes sure we read the completions even if nothing is written.
+    if (socket->zerocopy_head != socket->zerocopy_tail &&
+        !(socket->flags & HTTP_SOCKET_FLAG_URING_POLLERR)) {
+      struct io_uring_sqe *sqe = http_uring_get_sqe(&pool->ring);
+      if (sqe == NULL)
+        return -1;
+
+      http_uring_prep_poll(sqe, socket->fd, POLLERR, false,
+                           __HTTP_SOCKET_POOL_URING_USER_DATA(
+                               HTTP_SOCKET_POOL_URING_OP_POLLERR,
+                               socket->generation, socket->fd));
+      socket->flags |= HTTP_SOCKET_FLAG_URING_POLLERR;
+    }
+
+    if (!want_out ||
+        (socket->flags &
+         (HTTP_SOCKET_FLAG_URING_POLLOUT | HTTP_SOCKET_FLAG_WRITE_READY)))
+      return 0;
+
+    struct io_uring_sqe *sqe = http_uring_get_sqe(&pool->ring);
+    if (sqe == NULL)
+      return -1;
+
+    http_uring_prep_poll(sqe, socket->fd, POLLOUT, false,
+                         __HTTP_SOCKET_POOL_URING_USER_DATA(
+                             HTTP_SOCKET_POOL_URING_OP_POLLOUT,
+                             socket->generation, socket->fd));
+    socket->flags |= HTTP_SOCKET_FLAG_URING_POLLOUT;
+
+    return 0;
+  }
+
+  return 0;
+}
+
+/// Arms the timer of the socket for what it is doing now, the header timer is
+///  only armed once per request, the body and write timers on progress.
+void __http_socket_pool__update_timer(http_server_socket_pool_t *pool,
+                                      http_socket_t *socket) {
+  http_socket_timer_kind_t kind;
+  int64_t timeout;
+  size_t progress = 0;
+
+  // Determines what the socket is waiting for, pending writes come first, a
+  //  client which does not take its responses should time out, even if it
+  //  keeps sending requests.
+  if (socket->n_pending_write_ops > 0) {
+    kind = HTTP_SOCKET_TIMER_WRITE;
+    timeout = HTTP_SOCKET_TIMEOUT_WRITE;
+    progress = socket->bytes_sent;
+  } else if (http_request_get_state(socket->request) ==
+             HTTP_REQUEST_STATE_RECEIVING_BODY) {
+    kind = HTTP_SOCKET_TIMER_BODY;
+    timeout = HTTP_SOCKET_TIMEOUT_BODY;
+    progress = socket->request->received_body_size;
+  } else if (http_request_get_state(socket->request) ==
+                 HTTP_REQUEST_STATE_RECEIVING_TYPE &&
+             socket->recv_buffer_level == 0) {
+    kind = HTTP_SOCKET_TIMER_IDLE;
+    timeout = HTTP_SOCKET_TIMEOUT_IDLE;
+  } else {
+    kind = HTTP_SOCKET_TIMER_HEADER;
+    timeout = HTTP_SOCKET_TIMEOUT_HEADER;
+  }
+
+  // Keeps the running timer if nothing changed, so a client trickling in
+  //  its headers can not keep extending its deadline.
+  if (socket->timer.armed && socket->timer.kind == kind &&
+      socket->timer_progress == progress)
+    return;
+
+  socket->timer.kind = kind;
+  socket->timer.data = socket;
+  socket->timer_progress = progress;
+
+  http_timer_wheel_arm(&pool->timers, &socket->timer, timeout);
+}
+
+/// Gets called by the timer wheel when the timer of a socket expired.
+void __http_socket_pool__on_timeout(http_timer_t *timer, void *arg) {
+  http_server_socket_pool_t *pool = (http_server_socket_pool_t *)arg;
+  http_socket_t *socket = (http_socket_t *)timer->data;
+
+  if (socket->flags & HTTP_SOCKET_FLAG_ZEROCOPY_LINGER)
+    __http_socket_pool__on_linger(pool, socket);
+  else
+    __http_socket_pool__close_socket(pool, socket);
+}
+
+/// Closes the specified socket, and unregisters it from the pool. A socket
+///  whose zero-copy buffers are still in use by the kernel lingers instead.
+void __http_socket_pool__close_socket(http_server_socket_pool_t *pool,
+                                      http_socket_t *socket) {
+  // The completions can only be read through the fd, so it stays open until
+  //  the kernel released every buffer it sends from.
+  if ((socket->flags & HTTP_SOCKET_FLAG_ZEROCOPY) &&
+      !(socket->flags & HTTP_SOCKET_FLAG_ZEROCOPY_LINGER) &&
+      __http_socket_pool__linger_socket(pool, socket) == 0)
+    return;
+
+  // In-flight io_uring requests hold a reference to the socket, so shut it
+  //  down first, this terminates them and the completions are ignored.
+  if (pool->engine == HTTP_SERVER_SOCKET_POOL_ENGINE_IO_URING)
+    shutdown(socket->fd, SHUT_RDWR);
+
+  close(socket->fd);
+  __http_socket_pool_unregister__by_fd(pool, socket->fd);
+}
+
+/// Keeps a closing socket around until the kernel completed its zero-copy
+///  buffers, returns -1 if there is nothing to wait for.
+int32_t __http_socket_pool__linger_socket(http_server_socket_pool_t *pool,
+                                          http_socket_t *socket) {
+  // Drops the writes which are still queued, the buffers which have already
+  //  been sent from are retained.
+  while (socket->n_pending_write_ops > 0)
+    http_socket_dequeue_write_op(socket);
+
+  __http_socket_pool__account_writes(pool, socket);
+
+  http_socket_zerocopy_complete(socket);
+  if (socket->zerocopy_head == socket->zerocopy_tail)
+    return -1;
+
+  // Sends what the kernel still has queued followed by a FIN, and ends the
+  //  requests the io_uring has in flight, from now on only the completions
+  //  are read.
+  shutdown(socket->fd, SHUT_RDWR);
+
+  socket->flags |= HTTP_SOCKET_FLAG_ZEROCOPY_LINGER;
+  __http_socket_pool__ready_remove(pool, socket);
+
+  // The receive buffer is of no use anymore.
+  if (socket->recv_buffer != NULL) {
+    http_buffer_pool_put(&pool->buffers, socket->recv_buffer,
+                         socket->recv_buffer_size);
+    socket->recv_buffer = NULL;
+  }
+
+  // The completions raise an event, but the io_uring engine does not poll
+  //  for them anymore, so the timer checks for them as well.
+  socket->linger_deadline = http_timer_wheel_now() + HTTP_SOCKET_TIMEOUT_LINGER;
+  socket->timer.kind = HTTP_SOCKET_TIMER_LINGER;
+  socket->timer.data = socket;
+  http_timer_wheel_arm(&pool->timers, &socket->timer,
+                       HTTP_SOCKET_LINGER_INTERVAL);
+
+  return 0;
+}
+
+/// Reads the zero-copy completions of a lingering socket, and closes it once
+///  all of its buffers are released.
+void __http_socket_pool__on_linger(http_server_socket_pool_t *pool,
+                                   http_socket_t *socket) {
+  http_socket_zerocopy_complete(socket);
+  if (socket->zerocopy_head == socket->zerocopy_tail) {
+    __http_socket_pool__close_socket(pool, socket);
+    return;
+  }
+
+  // If the client does not take the data, the connection is aborted, the
+  //  kernel then drops what it did not send and completes the buffers.
+  if (http_timer_wheel_now() >= socket->linger_deadline) {
+    struct sockaddr addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sa_family = AF_UNSPEC;
+    connect(socket->fd, &addr, sizeof(addr));
+  }
+
+  http_timer_wheel_arm(&pool->timers, &socket->timer,
+                       HTTP_SOCKET_LINGER_INTERVAL);
 }
 
 /// Unregisters an socket with the specified fd.
@@ -793,144 +2213,630 @@ void __http_socket_pool_unregister__by_fd(http_server_socket_pool_t *pool,
   if (pool->end == socket)
     pool->end = socket->prev;
 
+  pool->sockets_by_fd[fd] = NULL;
   --pool->socket_count;
 
-  http_socket_free(&socket);
+  http_timer_wheel_cancel(&pool->timers, &socket->timer);
+  __http_socket_pool__ready_remove(pool, socket);
+
+  // Gives the receive buffer back, even if there is unprocessed data.
+  if (socket->recv_buffer != NULL) {
+    http_buffer_pool_put(&pool->buffers, socket->recv_buffer,
+                         socket->recv_buffer_size);
+    socket->recv_buffer = NULL;
+  }
+
+  // Removes the socket from the load of the pool.
+  __atomic_sub_fetch(&pool->load.connections, 1, __ATOMIC_RELAXED);
+  __atomic_sub_fetch(&pool->load.write_bytes, socket->write_bytes_accounted,
+                     __ATOMIC_RELAXED);
+
+  __http_socket_pool__release_socket(pool, socket);
+}
+
+/// Makes sure the fd-indexed socket table can hold the specified fd.
+int32_t __http_socket_pool__reserve_fd(http_server_socket_pool_t *pool,
+                                       int32_t fd) {
+  if ((size_t)fd < pool->sockets_by_fd_size)
+    return 0;
+
+  // Doubles the size of the table until the fd fits.
+  size_t size = pool->sockets_by_fd_size;
+  while ((size_t)fd >= size)
+    size *= 2;
+
+  http_socket_t **table = (http_socket_t **)realloc(
+      pool->sockets_by_fd, size * sizeof(http_socket_t *));
+  if (table == NULL)
+    return -1;
+
+  // Clears the newly allocated part of the table.
+  memset(&table[pool->sockets_by_fd_size], 0,
+         (size - pool->sockets_by_fd_size) * sizeof(http_socket_t *));
+
+  pool->sockets_by_fd = table;
+  pool->sockets_by_fd_size = size;
+
+  return 0;
 }
 
 /// Gets an socket by fd.
 http_socket_t *
 __http_socket_pool__get_socket_by_fd(http_server_socket_pool_t *pool,
                                      int32_t fd) {
-  http_socket_t *res = NULL;
-
-  http_socket_t *current = pool->start;
-  while (current != NULL) {
-    if (current->fd == fd) {
-      res = current;
-      break;
-    }
+  if (fd < 0 || (size_t)fd >= pool->sockets_by_fd_size)
+    return NULL;
 
-    current = current->next;
-  }
+  return pool->sockets_by_fd[fd];
+}
 
-  return res;
+/// Gets the load of the pool, the pending write bytes are weighed against
+///  the number of connections.
+size_t __http_server_socket_pool_load(http_server_socket_pool_t *pool) {
+  return __atomic_load_n(&pool->load.connections, __ATOMIC_RELAXED) +
+         __atomic_load_n(&pool->load.write_bytes, __ATOMIC_RELAXED) /
+             HTTP_SERVER_SOCKET_POOL_LOAD_BYTES_PER_CONNECTION;
 }
 
-/// Event loop for HTTP server pool process.
-void *__http_socket_pool_method(void *arg) {
-  __http_socket_pool_method__arg *args = (__http_socket_pool_method__arg *)arg;
+/// Adds the write bytes the socket queued or wrote since the last call to
+///  the load of the pool.
+void __http_socket_pool__account_writes(http_server_socket_pool_t *pool,
+                                        http_socket_t *socket) {
+  if (socket->write_bytes_pending == socket->write_bytes_accounted)
+    return;
 
+  // Unsigned wrap-around makes the subtraction also work when it shrunk.
+  __atomic_add_fetch(&pool->load.write_bytes,
+                     socket->write_bytes_pending - socket->write_bytes_accounted,
+                     __ATOMIC_RELAXED);
+  socket->write_bytes_accounted = socket->write_bytes_pending;
+}
+
+/// Event loop for the epoll engine.
+void __http_socket_pool_method__epoll(http_server_socket_t *sock,
+                                      http_server_socket_pool_t *pool) {
   // Stays in loop as long as shutdown is not rqeuested.
   for (;;) {
-    // Locks the mutex and allocates the memory which we will use to store
-    //  the polling results in.
-
-    pthread_mutex_lock(&args->pool->mutex);
-
-    // Loops over all the sockets specified in the pool information, after which
-    //  we construct our list of poll file descriptors and register each one of
-    //  them.
-
-    {
-      const http_socket_t *socket = args->pool->start;
-      for (size_t i = 0; i < args->pool->socket_count; ++i) {
-        if (socket == NULL) {
-          fprintf(stderr,
-                  "socket->next == NULL, this should not happen normally!\r\n");
-        }
+    // Waits for events on any of the registered sockets, the sockets are
+    //  registered only once, so there is no per-iteration setup cost.
+    //  If sockets are waiting on the ready list, we only poll.
+    int32_t n_events = epoll_wait(
+        pool->epoll_fd, pool->events, HTTP_SERVER_SOCKET_POOL_MAX_EVENTS,
+        pool->ready_start != NULL ? 0 : HTTP_SERVER_SOCKET_POOL_WAIT_TIMEOUT);
+    if (n_events == -1) {
+      // Since it's an actual error message, print it.
+      if (errno != EINTR)
+        perror("epoll_wait () failed");
+      n_events = 0;
+    }
 
-        // Adds the default events we're interested in.
-        args->pool->fds[i].events = POLLIN | POLLERR | POLLHUP;
+    // Refreshes the shared Date header, if a second passed while waiting.
+    http_date_update();
 
-        // Checks if we've got anything left to write, if so
-        //  add the pollout event.
-        if (socket->n_pending_write_ops > 0)
-          args->pool->fds[i].events |= POLLOUT;
+    // Loops over all the sockets which reported an event, if one of them
+    //  fails we will close the socket and remove it from the linked list.
 
-        args->pool->fds[i].fd = socket->fd;
+    for (int32_t i = 0; i < n_events; ++i) {
+      uint32_t events = pool->events[i].events;
+      bool should_close = false;
 
-        socket = socket->next;
+      // Checks if the event belongs to the pool listener, if so accept the
+      //  new connections.
+      if (pool->events[i].data.fd == pool->listen_fd) {
+        __http_socket_pool__on_acceptable(pool);
+        continue;
       }
-    }
-
-    // Unlocks the mutex (allows new clients to be added)
-    pthread_mutex_unlock(&args->pool->mutex);
-
-    // Polls the FD's with an timeout of 1 millisecond, after which we check the
-    // return
-    //  code and (possibly) jump to retry, else we either print an error or
-    //  continue further.
 
-    int poll_rc;
+      // Checks if the acceptor woke us up, if so register the new sockets.
+      if (pool->events[i].data.fd == pool->wake_fd) {
+        __http_socket_pool__drain_incoming(pool);
+        continue;
+      }
 
-  poll_retry:
-    poll_rc = poll(args->pool->fds, args->pool->socket_count, 0);
-    if (poll_rc == -1) {
-      // Checks if the errno tells us to try again.
-      if (errno == EAGAIN)
-        goto poll_retry;
+      // Only this thread touches the sockets of the pool, so no locking is
+      //  needed to look one up.
+      http_socket_t *socket = __http_socket_pool__get_socket_by_fd(
+          pool, pool->events[i].data.fd);
 
-      // Since it's an actual error message, print it.
-      perror("poll () failed");
-      continue;
-    }
+      if (socket == NULL)
+        continue;
 
-    // Loops over all the sockets in the pool and polls for events, if one of
-    // them
-    //  fail we will mark the socket as 'to close' and later remove it from the
-    //  linked list.
+      // A lingering socket only waits for its zero-copy completions.
+      if (socket->flags & HTTP_SOCKET_FLAG_ZEROCOPY_LINGER) {
+        __http_socket_pool__on_linger(pool, socket);
+        continue;
+      }
 
-    for (int32_t i = 0; i < poll_rc; ++i) {
-      int16_t revents = args->pool->fds[i].revents;
-      bool should_close = false;
+      // With zero-copy enabled, the completions also raise EPOLLERR, this
+      //  only closes the socket if it is an actual error.
+      if ((events & EPOLLERR) && (socket->flags & HTTP_SOCKET_FLAG_ZEROCOPY)) {
+        if (http_socket_zerocopy_complete(socket) != 0)
+          should_close = true;
 
-      pthread_mutex_lock(&args->pool->mutex);
-      http_socket_t *socket = __http_socket_pool__get_socket_by_fd(
-          args->pool, args->pool->fds[i].fd);
-      pthread_mutex_unlock(&args->pool->mutex);
+        events &= ~EPOLLERR;
+      }
 
-      if (revents & POLLIN) {
-        if (__http_socket_pool__on_readable(args->sock, args->pool, socket) !=
+      if (!should_close && (events & EPOLLIN)) {
+        if (__http_socket_pool__on_readable(sock, pool, socket) !=
             0) {
           should_close = true;
         }
       }
 
-      if (revents & POLLOUT) {
-        if (__http_socket_pool__on_writable(args->sock, args->pool, socket) !=
+      // Writes the responses the request callbacks queued right away, the
+      //  socket most likely has buffer space, if not, EPOLLOUT reports once
+      //  it does. Sockets on the ready list get their turn after the events.
+      if (!should_close && socket->n_pending_write_ops > 0 &&
+          !(socket->flags & HTTP_SOCKET_FLAG_WRITE_READY)) {
+        if (__http_socket_pool__on_writable(sock, pool, socket) !=
             0) {
           should_close = true;
         }
       }
 
-      // If an error has occured, or the connection has been closed, lock the
-      // mutex
-      //  and mark the socket as 'should close'.
+      // Publishes the writes the socket queued or finished, and updates its
+      //  timeout.
+      if (!should_close &&
+          __http_socket_pool__update_events(pool, socket) != 0)
+        should_close = true;
 
-      if (revents & POLLERR || revents & POLLHUP || should_close) {
-        pthread_mutex_lock(&args->pool->mutex);
+      // If an error has occured, or the connection has been closed, close the
+      //  socket, closing it also removes it from epoll.
 
-        close(socket->fd);
-        __http_socket_pool_unregister__by_fd(args->pool, socket->fd);
-
-        pthread_mutex_unlock(&args->pool->mutex);
-      }
+      if (events & EPOLLERR || events & EPOLLHUP || should_close)
+        __http_socket_pool__close_socket(pool, socket);
     }
 
+    // Continues writing to the sockets which spent their write budget.
+    __http_socket_pool__flush_ready(sock, pool);
+
+    // Closes the sockets whose timeout expired, the wait timeout makes sure
+    //  we get here at least once every tick.
+    http_timer_wheel_advance(&pool->timers, __http_socket_pool__on_timeout,
+                             pool);
+
     // Checks if we need to shut down acceptor thread.
-    if (args->pool->flags & HTTP_SERVER_SOCKET_POOL_FLAG_SHUTDOWN) {
-      __http_server_socket_log(args->sock, "Pool received shutdown signal ...");
+    if (pool->flags & HTTP_SERVER_SOCKET_POOL_FLAG_SHUTDOWN) {
+      __http_server_socket_log(sock, "Pool received shutdown signal ...");
       break;
     }
+  }
 
-    // Sleeps to save CPU usage, based on the number of clients we will
-    // determine
-    //  if it's acceptable to use 100% cpu usage.
-    if (args->pool->socket_count > 50)
-      usleep(0);
-    else
+}
+
+/// Posts the multishot receive of a socket to the io_uring.
+int32_t __http_socket_pool__uring_arm_recv(http_server_socket_pool_t *pool,
+                                           http_socket_t *socket) {
+  struct io_uring_sqe *sqe = http_uring_get_sqe(&pool->ring);
+  if (sqe == NULL)
+    return -1;
+
+  http_uring_prep_recv_multishot(
+      sqe, socket->fd,
+      __HTTP_SOCKET_POOL_URING_USER_DATA(HTTP_SOCKET_POOL_URING_OP_RECV,
+                                         socket->generation, socket->fd));
+
+  return 0;
+}
+
+/// Registers a socket from the pool thread, and posts its receive when
+///  using io_uring, closes the socket if this fails.
+void __http_socket_pool__adopt_socket(http_server_socket_pool_t *pool,
+                                      http_socket_t *socket) {
+  // Checks if the socket could be registered, if not the pool is full, so
+  //  close the connection.
+  if (__http_socket_pool_register_socket(pool, socket) != 0) {
+    __atomic_sub_fetch(&pool->load.connections, 1, __ATOMIC_RELAXED);
+    close(socket->fd);
+    __http_socket_pool__release_socket(pool, socket);
+    return;
+  }
+
+  // Since we're the pool thread, we can post the receive right away.
+  if (pool->engine == HTTP_SERVER_SOCKET_POOL_ENGINE_IO_URING &&
+      __http_socket_pool__uring_arm_recv(pool, socket) != 0) {
+    __http_socket_pool__close_socket(pool, socket);
+    return;
+  }
+
+  // Starts the idle timer, so a client which never sends anything is closed.
+  __http_socket_pool__update_timer(pool, socket);
+}
+
+/// Registers all the connections the acceptor handed over through the incoming
+///  queue.
+void __http_socket_pool__drain_incoming(http_server_socket_pool_t *pool) {
+  // Clears the eventfd counter before popping, a connection pushed after this
+  //  will write to the eventfd again, so it can never be missed.
+  eventfd_t value;
+  eventfd_read(pool->wake_fd, &value);
+
+  http_server_socket_pool__incoming_t conn;
+  while (http_mpsc_queue_pop(&pool->incoming, &conn))
+    __http_socket_pool__register_accepted(pool, conn.fd, &conn.address);
+}
+
+/// Posts the multishot accept of the pool listener to the io_uring.
+int32_t __http_socket_pool__uring_arm_accept(http_server_socket_pool_t *pool) {
+  struct io_uring_sqe *sqe = http_uring_get_sqe(&pool->ring);
+  if (sqe == NULL)
+    return -1;
+
+  // The peer address is not requested, since all completions would share
+  //  the same address buffer.
+  sqe->opcode = IORING_OP_ACCEPT;
+  sqe->fd = pool->listen_fd;
+  sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+  sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+  sqe->user_data = __HTTP_SOCKET_POOL_URING_USER_DATA(
+      HTTP_SOCKET_POOL_URING_OP_ACCEPT, 0, pool->listen_fd);
+
+  return 0;
+}
+
+/// Creates the socket for an accepted connection and registers it, the
+///  connection must already be counted in the load of the pool.
+void __http_socket_pool__register_accepted(http_server_socket_pool_t *pool,
+                                           int32_t fd,
+                                           struct sockaddr_in *address) {
+  // Takes the socket from the slab of the pool, in the steady state this
+  //  does not allocate anything.
+  http_socket_t *socket = __http_socket_pool__alloc_socket(pool);
+  if (socket == NULL) {
+    __atomic_sub_fetch(&pool->load.connections, 1, __ATOMIC_RELAXED);
+    close(fd);
+    return;
+  }
+
+  if (address != NULL)
+    socket->address = *address;
+  socket->fd = fd;
+  socket->creation_time = time(NULL);
+
+  // A response leaves with a single gather write, so there is nothing for
+  //  Nagle to coalesce, it would only delay the next pipelined response.
+  int32_t nodelay = 1;
+  if (setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay)) != 0)
+    perror("setsockopt (IPPROTO_TCP, TCP_NODELAY) failed");
+
+  // Zero-copy sends must be enabled per socket, if the kernel does not
+  //  support it there's no point in trying again for the next one.
+  if (pool->zerocopy) {
+    int32_t zerocopy = 1;
+    if (setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &zerocopy, sizeof(zerocopy)) ==
+        0)
+      socket->flags |= HTTP_SOCKET_FLAG_ZEROCOPY;
+    else {
+      perror("setsockopt (SOL_SOCKET, SO_ZEROCOPY) failed");
+      pool->zerocopy = false;
+    }
+  }
+
+  __http_socket_pool__adopt_socket(pool, socket);
+}
+
+/// Accepts the pending connections of the pool listener (epoll engine).
+void __http_socket_pool__on_acceptable(http_server_socket_pool_t *pool) {
+  for (size_t i = 0; i < HTTP_SERVER_SOCKET_POOL_ACCEPT_BATCH; ++i) {
+    struct sockaddr_in address;
+    socklen_t address_len = sizeof(address);
+
+    int32_t fd = accept4(pool->listen_fd, (struct sockaddr *)&address,
+                         &address_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR &&
+          errno != ECONNABORTED)
+        perror("accept4 () failed");
+      return;
+    }
+
+    __atomic_add_fetch(&pool->load.connections, 1, __ATOMIC_RELAXED);
+    __http_socket_pool__register_accepted(pool, fd, &address);
+  }
+}
+
+/// Copies data received by io_uring into the receive buffer and processes
+///  it, what arrives while the socket is throttled is kept aside.
+int32_t __http_socket_pool__uring_receive(http_server_socket_t *sock,
+                                          http_server_socket_pool_t *pool,
+                                          http_socket_t *socket,
+                                          const uint8_t *data, size_t size) {
+  // The receive keeps posting data until its cancellation went through, the
+  //  requests in there wait until the socket resumes.
+  if (socket->flags & HTTP_SOCKET_FLAG_THROTTLED) {
+    uint8_t *backlog = (uint8_t *)realloc(socket->recv_backlog,
+                                          socket->recv_backlog_size + size);
+    if (backlog == NULL)
+      return -1;
+
+    memcpy(&backlog[socket->recv_backlog_size], data, size);
+    socket->recv_backlog = backlog;
+    socket->recv_backlog_size += size;
+
+    return 0;
+  }
+
+  // Processes the data as it's copied in, this may take multiple rounds if
+  //  the buffer does not have enough space left.
+  while (size > 0) {
+    // Makes sure there is space left in the receive buffer, one byte is
+    //  reserved for the NULL-termination of the lines.
+    if (__http_socket_pool__reserve_recv_buffer(pool, socket) != 0)
+      return -3;
+
+    size_t n = socket->recv_buffer_size - 1 - socket->recv_buffer_level;
+    if (n > size)
+      n = size;
+
+    memcpy(&socket->recv_buffer[socket->recv_buffer_level], data, n);
+    socket->recv_buffer_level += n;
+    data += n;
+    size -= n;
+
+    if (__http_socket_pool__on_readable__process(sock, pool, socket) != 0)
+      return -1;
+
+    // Processing may have throttled the socket, the rest is kept aside.
+    if (size > 0 && (socket->flags & HTTP_SOCKET_FLAG_THROTTLED))
+      return __http_socket_pool__uring_receive(sock, pool, socket, data, size);
+  }
+
+  return 0;
+}
+
+/// Handles an io_uring receive completion.
+int32_t __http_socket_pool__uring_on_recv(http_server_socket_t *sock,
+                                          http_server_socket_pool_t *pool,
+                                          http_socket_t *socket,
+                                          struct io_uring_cqe *cqe) {
+  // Checks if the receive has terminated, when we ran out of buffers it
+  //  just needs to be posted again, anything else means closed or error.
+  if (cqe->res <= 0) {
+    if (cqe->res == -ENOBUFS || cqe->res == -ECANCELED)
+      return __http_socket_pool__uring_rearm_recv(pool, socket);
+    else if (cqe->res < 0 && cqe->res != -ECONNRESET)
+      fprintf(stderr, "recv () failed: %s\r\n", strerror(-cqe->res));
+    return -1;
+  }
+
+  // Copies the received data out of the provided buffer.
+  if (__http_socket_pool__uring_receive(
+          sock, pool, socket,
+          http_uring_get_buffer(&pool->ring,
+                                cqe->flags >> IORING_CQE_BUFFER_SHIFT),
+          (size_t)cqe->res) != 0)
+    return -1;
+
+  // The buffer is not needed until the next completion, if it's empty.
+  __http_socket_pool__release_recv_buffer(pool, socket);
+
+  // If the kernel terminated the multishot receive, post it again.
+  if (!(cqe->flags & IORING_CQE_F_MORE))
+    return __http_socket_pool__uring_rearm_recv(pool, socket);
+
+  return 0;
+}
+
+/// Posts the receive of a socket again after the kernel terminated it, a
+///  throttled socket gets it once it resumes.
+int32_t __http_socket_pool__uring_rearm_recv(http_server_socket_pool_t *pool,
+                                             http_socket_t *socket) {
+  socket->flags &= ~HTTP_SOCKET_FLAG_URING_RECV_CANCEL;
+
+  if (socket->flags & HTTP_SOCKET_FLAG_THROTTLED) {
+    socket->flags |= HTTP_SOCKET_FLAG_URING_RECV_IDLE;
+    return 0;
+  }
+
+  return __http_socket_pool__uring_arm_recv(pool, socket);
+}
+
+/// Handles a single io_uring completion.
+void __http_socket_pool__uring_on_cqe(http_server_socket_t *sock,
+                                      http_server_socket_pool_t *pool,
+                                      struct io_uring_cqe *cqe) {
+  uint32_t op = __HTTP_SOCKET_POOL_URING_USER_DATA_OP(cqe->user_data);
+  bool should_close = false;
+
+  // Checks if the acceptor woke us up, if so register the new sockets.
+  if (op == HTTP_SOCKET_POOL_URING_OP_WAKE) {
+    __http_socket_pool__drain_incoming(pool);
+
+    if (!(cqe->flags & IORING_CQE_F_MORE)) {
+      struct io_uring_sqe *sqe = http_uring_get_sqe(&pool->ring);
+      if (sqe != NULL)
+        http_uring_prep_poll(sqe, pool->wake_fd, POLLIN, true, cqe->user_data);
+    }
+
+    return;
+  }
+
+  // Checks if the pool listener accepted a new connection, if the kernel
+  //  terminated the multishot accept, post it again.
+  if (op == HTTP_SOCKET_POOL_URING_OP_ACCEPT) {
+    if (cqe->res >= 0) {
+      __atomic_add_fetch(&pool->load.connections, 1, __ATOMIC_RELAXED);
+      __http_socket_pool__register_accepted(pool, cqe->res, NULL);
+    }
+    else if (cqe->res != -EAGAIN && cqe->res != -ECONNABORTED)
+      fprintf(stderr, "accept () failed: %s\r\n", strerror(-cqe->res));
+
+    if (!(cqe->flags & IORING_CQE_F_MORE) &&
+        !(pool->flags & HTTP_SERVER_SOCKET_POOL_FLAG_SHUTDOWN))
+      __http_socket_pool__uring_arm_accept(pool);
+
+    return;
+  }
+
+  // The receive it cancelled reports the outcome.
+  if (op == HTTP_SOCKET_POOL_URING_OP_CANCEL)
+    return;
+
+  // Gets the socket the completion belongs to, if it's not there anymore, or
+  //  the fd belongs to a new socket, the completion is stale.
+  http_socket_t *socket = __http_socket_pool__get_socket_by_fd(
+      pool, __HTTP_SOCKET_POOL_URING_USER_DATA_FD(cqe->user_data));
+
+  if (socket == NULL ||
+      socket->generation !=
+          __HTTP_SOCKET_POOL_URING_USER_DATA_GENERATION(cqe->user_data)) {
+    if (cqe->flags & IORING_CQE_F_BUFFER)
+      http_uring_recycle_buffer(&pool->ring,
+                                cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+    return;
+  }
+
+  // A lingering socket only waits for its zero-copy completions, the polls
+  //  it still had in flight are not posted again.
+  if (socket->flags & HTTP_SOCKET_FLAG_ZEROCOPY_LINGER) {
+    if (cqe->flags & IORING_CQE_F_BUFFER)
+      http_uring_recycle_buffer(&pool->ring,
+                                cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+
+    socket->flags &=
+        ~(HTTP_SOCKET_FLAG_URING_POLLOUT | HTTP_SOCKET_FLAG_URING_POLLERR);
+    __http_socket_pool__on_linger(pool, socket);
+    return;
+  }
+
+  switch (op) {
+  case HTTP_SOCKET_POOL_URING_OP_RECV:
+    if (__http_socket_pool__uring_on_recv(sock, pool, socket, cqe) != 0)
+      should_close = true;
+
+    // Writes the responses the request callbacks queued right away, the
+    //  writability poll is only posted if the socket buffer is full.
+    else if (socket->n_pending_write_ops > 0 &&
+             !(socket->flags & (HTTP_SOCKET_FLAG_URING_POLLOUT |
+                                HTTP_SOCKET_FLAG_WRITE_READY)) &&
+             __http_socket_pool__on_writable(sock, pool, socket) != 0)
+      should_close = true;
+
+    // Gives the buffer back, we've copied the data out of it.
+    if (cqe->flags & IORING_CQE_F_BUFFER)
+      http_uring_recycle_buffer(&pool->ring,
+                                cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+    break;
+  case HTTP_SOCKET_POOL_URING_OP_POLLOUT:
+    socket->flags &= ~HTTP_SOCKET_FLAG_URING_POLLOUT;
+
+    // With zero-copy enabled, the completions also raise POLLERR.
+    if (cqe->res >= 0 && (cqe->res & POLLERR) &&
+        (socket->flags & HTTP_SOCKET_FLAG_ZEROCOPY) &&
+        http_socket_zerocopy_complete(socket) == 0)
+      cqe->res &= ~POLLERR;
+
+    if (cqe->res < 0 || (cqe->res & (POLLERR | POLLHUP)))
+      should_close = true;
+    else if (__http_socket_pool__on_writable(sock, pool, socket) != 0)
+      should_close = true;
+    break;
+  case HTTP_SOCKET_POOL_URING_OP_POLLERR:
+    socket->flags &= ~HTTP_SOCKET_FLAG_URING_POLLERR;
+
+    if (cqe->res < 0 || (cqe->res & POLLHUP) ||
+        http_socket_zerocopy_complete(socket) != 0)
+      should_close = true;
+    break;
+  default:
+    break;
+  }
+
+  // Posts the writability poll if the request callback queued any write
+  //  operations, it will be submitted with the rest of this iteration.
+  if (!should_close && __http_socket_pool__update_events(pool, socket) != 0)
+    should_close = true;
+
+  if (should_close)
+    __http_socket_pool__close_socket(pool, socket);
+}
+
+/// Event loop for the io_uring engine.
+void __http_socket_pool_method__uring(http_server_socket_t *sock,
+                                      http_server_socket_pool_t *pool) {
+  // Stays in loop as long as shutdown is not rqeuested.
+  for (;;) {
+    // Submits everything we've prepared in the previous iteration with a
+    //  single system call, and waits for new completions. If sockets are
+    //  waiting on the ready list, we only submit.
+    if (pool->ready_start != NULL) {
+      if (__http_uring_enter(&pool->ring, 0, 0) < 0 && errno != EINTR &&
+          errno != EAGAIN && errno != EBUSY)
+        perror("io_uring_enter () failed");
+    } else if (http_uring_submit_and_wait(
+                   &pool->ring, HTTP_SERVER_SOCKET_POOL_WAIT_TIMEOUT) != 0)
       usleep(1000);
+
+    // Refreshes the shared Date header, if a second passed while waiting.
+    http_date_update();
+
+    // Handles all the completions which are available.
+    struct io_uring_cqe *cqe;
+    while ((cqe = http_uring_peek_cqe(&pool->ring)) != NULL) {
+      __http_socket_pool__uring_on_cqe(sock, pool, cqe);
+      http_uring_cqe_seen(&pool->ring);
+    }
+
+    // Continues writing to the sockets which spent their write budget.
+    __http_socket_pool__flush_ready(sock, pool);
+
+    // Closes the sockets whose timeout expired, the wait timeout makes sure
+    //  we get here at least once every tick.
+    http_timer_wheel_advance(&pool->timers, __http_socket_pool__on_timeout,
+                             pool);
+
+    // Checks if we need to shut down acceptor thread.
+    if (pool->flags & HTTP_SERVER_SOCKET_POOL_FLAG_SHUTDOWN) {
+      __http_server_socket_log(sock, "Pool received shutdown signal ...");
+      break;
+    }
+  }
+}
+
+/// Moves the memory of a pinned pool to its own NUMA node, by re-allocating
+///  it from the pool thread itself (first touch).
+void __http_socket_pool__localize(http_server_socket_pool_t *pool) {
+  // The kernel places a page on the node of the CPU which first touches it,
+  //  and glibc gives this thread its own malloc arena, so copying the tables
+  //  here moves them to our node. Everything the pool allocates from now on,
+  //  requests, responses and write operations, ends up there as well.
+  http_socket_t **sockets_by_fd = (http_socket_t **)malloc(
+      pool->sockets_by_fd_size * sizeof(http_socket_t *));
+  if (sockets_by_fd != NULL) {
+    memcpy(sockets_by_fd, pool->sockets_by_fd,
+           pool->sockets_by_fd_size * sizeof(http_socket_t *));
+    free(pool->sockets_by_fd);
+    pool->sockets_by_fd = sockets_by_fd;
+  }
+
+  if (pool->engine == HTTP_SERVER_SOCKET_POOL_ENGINE_EPOLL) {
+    struct epoll_event *events = (struct epoll_event *)calloc(
+        HTTP_SERVER_SOCKET_POOL_MAX_EVENTS, sizeof(struct epoll_event));
+    if (events != NULL) {
+      free(pool->events);
+      pool->events = events;
+    }
+  }
+}
+
+/// Event loop for HTTP server pool process.
+void *__http_socket_pool_method(void *arg) {
+  __http_socket_pool_method__arg *args = (__http_socket_pool_method__arg *)arg;
+
+  // Now that we're running on our own CPU, move the pool memory to our node.
+  if (args->pool->flags & HTTP_SERVER_SOCKET_POOL_FLAG_PINNED)
+    __http_socket_pool__localize(args->pool);
+
+  // Runs the event loop of the engine the pool was created with.
+  switch (args->pool->engine) {
+  case HTTP_SERVER_SOCKET_POOL_ENGINE_EPOLL:
+    __http_socket_pool_method__epoll(args->sock, args->pool);
+    break;
+  case HTTP_SERVER_SOCKET_POOL_ENGINE_IO_URING:
+    __http_socket_pool_method__uring(args->sock, args->pool);
+    break;
+  default:
+    break;
   }
 
   // Frees the thread pool argument, and returns null.
@@ -942,9 +2848,12 @@ void *__http_socket_pool_method(void *arg) {
 int32_t http_server_start_thread_pools(http_server_socket_t *sock) {
   for (size_t i = 0; i < sock->thread_pool_count; ++i) {
     __http_server_socket_pool_start(sock, sock->pools[i]);
-    __http_server_socket_log(sock,
-                             "Socket pool %lu of %lu created and running.", i,
-                             sock->thread_pool_count);
+    __http_server_socket_log(
+        sock, "Socket pool %lu of %lu created and running (cpu %d%s).", i,
+        sock->thread_pool_count, sock->pools[i]->cpu,
+        sock->pools[i]->flags & HTTP_SERVER_SOCKET_POOL_FLAG_PINNED
+            ? ", pinned"
+            : "");
   }
 
   return 0;
@@ -954,66 +2863,109 @@ int32_t http_server_start_thread_pools(http_server_socket_t *sock) {
 // HTTP Server Socket Acceptor
 ///////////////////////////////////////////////////////////////////////////////
 
-/// Accepts an client socket, returns NULL if not possible.
-http_socket_t *__http_server__accept_socket(http_server_socket_t *sock) {
-  struct sockaddr_in client_addr;
-  socklen_t client_addr_len = sizeof(client_addr);
+/// Accepts an client connection, returns -1 if not possible.
+int32_t __http_server__accept_socket(http_server_socket_t *sock,
+                                     http_server_socket_pool__incoming_t *conn) {
+  socklen_t address_len = sizeof(conn->address);
 
-  // Accepts the new client socket, and if this returns < 0 we will return
-  //  NULL since nothing got accepted.
-  int32_t fd =
-      accept(sock->fd, (struct sockaddr *)&client_addr, &client_addr_len);
-  if (fd < 0) {
-    return NULL;
-  }
+  // Accepts the new client socket, the socket is made non-blocking right
+  //  away, this is important since we need to use polling.
+  conn->fd = accept4(sock->fd, (struct sockaddr *)&conn->address, &address_len,
+                     SOCK_NONBLOCK | SOCK_CLOEXEC);
+  if (conn->fd < 0)
+    return -1;
 
-  // Makes the socket non-blocking, this is important since we need to
-  //  use polling.
-  int flags;
-  if ((flags = fcntl(fd, F_GETFL)) < 0) {
-    perror("fcntl (F_GETFL) failed");
-    return NULL;
-  } else if (fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
-    perror("fcntl (F_SETFL) failed");
-    return NULL;
+  return 0;
+}
+
+/// Selects the index of the pool a new socket should go to, according to the
+///  placement policy of the server.
+size_t __http_server_acceptor__select_pool(http_server_socket_t *sock,
+                                           const struct sockaddr_in *address) {
+  size_t count = sock->thread_pool_count;
+
+  switch (sock->placement) {
+  case HTTP_SERVER_SOCKET_PLACEMENT_LEAST_CONNECTIONS: {
+    size_t best = 0, best_connections = SIZE_MAX;
+
+    for (size_t i = 0; i < count; ++i) {
+      size_t connections =
+          __atomic_load_n(&sock->pools[i]->load.connections, __ATOMIC_RELAXED);
+      if (connections < best_connections) {
+        best = i;
+        best_connections = connections;
+      }
+    }
+
+    return best;
   }
+  case HTTP_SERVER_SOCKET_PLACEMENT_POWER_OF_TWO: {
+    // With a single pool there is nothing to choose from.
+    if (count == 1)
+      return 0;
 
-  // Allocates the memory required to keep the HTTP socket, if this fails
-  //  close the FD and return null.
-  http_socket_t *socket = http_socket_new();
-  if (socket == NULL) {
-    close(fd);
-    return NULL;
+    // Picks two distinct random pools with xorshift, the second one is drawn
+    //  from the other pools, else the comparison would often be against the
+    //  same pool. There is only one acceptor thread so the state needs no
+    //  locking.
+    uint32_t x = sock->placement_random;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    sock->placement_random = x;
+
+    size_t a = (x & 0xFFFF) % count;
+    size_t b = (a + 1 + (x >> 16) % (count - 1)) % count;
+    return __http_server_socket_pool_load(sock->pools[a]) <=
+                   __http_server_socket_pool_load(sock->pools[b])
+               ? a
+               : b;
+  }
+  case HTTP_SERVER_SOCKET_PLACEMENT_ADDRESS_HASH: {
+    // Fibonacci hashing of the client address, so the same client always
+    //  ends up in the same pool. The multiplication mixes the address into
+    //  the high bits only, so those pick the pool, scaled to the count.
+    uint32_t hash = ntohl(address->sin_addr.s_addr) * 2654435761u;
+    return (size_t)(((uint64_t)hash * count) >> 32);
+  }
+  case HTTP_SERVER_SOCKET_PLACEMENT_ROUND_ROBIN:
+  default:
+    return (sock->thread_pool_register_next + 1) % count;
   }
+}
 
-  // Configures the http socket.
-  socket->address = client_addr;
-  socket->fd = fd;
-  socket->creation_time = time(NULL);
+/// Hands an accepted connection to the selected pool, through its incoming
+///  queue.
+void __http_server_acceptor__register_socket(
+    http_server_socket_t *sock, const http_server_socket_pool__incoming_t *conn) {
+  // Pushes the connection to the selected pool, if its queue is full (the
+  //  pool is lagging behind) try the ones after it. The pool creates the
+  //  socket itself, from its own slab.
+  size_t index = __http_server_acceptor__select_pool(sock, &conn->address);
 
-  // Returns the socket.
-  return socket;
-}
+  for (size_t i = 0; i < sock->thread_pool_count; ++i) {
+    http_server_socket_pool_t *pool =
+        sock->pools[(index + i) % sock->thread_pool_count];
+
+    // Counts the connection before the push, so the next placement already
+    //  sees it, even though the pool did not register it yet.
+    __atomic_add_fetch(&pool->load.connections, 1, __ATOMIC_RELAXED);
+    if (!http_mpsc_queue_push(&pool->incoming, conn)) {
+      __atomic_sub_fetch(&pool->load.connections, 1, __ATOMIC_RELAXED);
+      continue;
+    }
 
-/// Registers an accepted socket
-void __http_server_acceptor__register_socket(http_server_socket_t *sock,
-                                             http_socket_t *socket) {
-  // Locks the mutex.
-  pthread_mutex_lock(&sock->acceptor_mutex);
-
-  // Determines which pool to register the socket to, after which we get it and
-  // register
-  //  the scket to it.
-  sock->thread_pool_register_next =
-      (sock->thread_pool_register_next + 1) % (sock->thread_pool_count);
-  http_server_socket_pool_t *pool =
-      sock->pools[sock->thread_pool_register_next];
-  __http_socket_pool_register_socket(pool, socket);
+    sock->thread_pool_register_next = (index + i) % sock->thread_pool_count;
+
+    // Wakes the pool, which will register the connection.
+    if (eventfd_write(pool->wake_fd, 1) != 0)
+      perror("eventfd_write () failed");
+
+    return;
+  }
 
-  // Unlocks the mutex and logs that we've registered the socket.
-  pthread_mutex_unlock(&sock->acceptor_mutex);
-  // __http_server_socket_log (sock, "Registering socket to pool %lu",
-  // sock->thread_pool_register_next);
+  // All the queues are full, so close the connection.
+  close(conn->fd);
 }
 
 /// Accepts incomming connections.
@@ -1022,16 +2974,9 @@ void *__http_server_acceptor(void *arg) {
 
   // Stays in loop as long as shutdown is not rqeuested.
   for (;;) {
-    http_socket_t *socket = NULL;
-    if ((socket = __http_server__accept_socket(sock)) != NULL) {
-      char *addr =
-          __http_helper__thread_safe__inet_ntoa(socket->address.sin_addr);
-      // __http_server_socket_log (sock, "Accepted %s:%u", addr, ntohs
-      // (socket->address.sin_port));
-      free(addr);
-
-      __http_server_acceptor__register_socket(sock, socket);
-    }
+    http_server_socket_pool__incoming_t conn;
+    if (__http_server__accept_socket(sock, &conn) == 0)
+      __http_server_acceptor__register_socket(sock, &conn);
   }
 
   return NULL;
@@ -1046,6 +2991,13 @@ int32_t http_server_start_acceptor(http_server_socket_t *sock,
     return -1;
   }
 
+  // When the pools accept on their own listeners, there is nothing to do.
+  if (http_server_socket_flag_is_set(sock,
+                                     HTTP_SERVER_SOCKET_FLAG_POOL_LISTENERS)) {
+    __http_server_socket_log(sock, "Pools accept on their own listeners.");
+    return 0;
+  }
+
   // Sets the acceptor thread created flag, to prevent it from being created
   // another time.
   sock->flags |= HTTP_SERVER_SOCKET_ACCEPTOR_THREAD_CREATED;
@@ -1072,6 +3024,10 @@ int32_t http_server_start_acceptor(http_server_socket_t *sock,
 
 /// Stops the acceptor.
 int32_t __http_server_socket_stop_acceptor(http_server_socket_t *sock) {
+  // Checks if there is any acceptor thread to stop.
+  if (!(sock->flags & HTTP_SERVER_SOCKET_ACCEPTOR_THREAD_CREATED))
+    return 0;
+
   // Cancels the thread.
   if (pthread_cancel(sock->acceptor_thread) != 0) {
     perror("pthread_cancel () failed");
@@ -0,0 +1,99 @@
+/*
+    Copyright 2021 Luke A.C.A. Rieff
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "http_status_line.h"
+
+char *g_HttpStatusLineBlock = NULL;
+http_status_line_t g_HttpStatusLines[HTTP_STATUS_LINE_VERSIONS]
+                                    [HTTP_STATUS_LINE_CODES];
+
+///////////////////////////////////////////////////////////////////////////////
+// HTTP Status Line
+///////////////////////////////////////////////////////////////////////////////
+
+/// Formats the status lines of all the known codes for every version, the
+///  invalid version gets the lines of HTTP/1.1.
+int32_t http_status_line_init(void) {
+  if (g_HttpStatusLineBlock != NULL)
+    return -1;
+
+  // Computes the size of all the lines, so they fit in a single block.
+  size_t size = 0;
+  for (uint32_t v = 0; v < HTTP_STATUS_LINE_VERSIONS; ++v) {
+    const char *version = http_version_to_string((http_version_t)v);
+    if (version == NULL)
+      version = http_version_to_string(HTTP_VERSION_1_1);
+
+    for (uint32_t c = 0; c < HTTP_STATUS_LINE_CODES; ++c) {
+      const char *message =
+          http_code_get_message((http_code_t)(c + HTTP_STATUS_LINE_MIN_CODE));
+      if (message != NULL)
+        size += strlen(version) + strlen(message) + 7;
+    }
+  }
+
+  g_HttpStatusLineBlock = (char *)malloc(size + 1);
+  if (g_HttpStatusLineBlock == NULL)
+    return -1;
+
+  // Formats the lines, the codes without a message keep an empty slot.
+  char *p = g_HttpStatusLineBlock;
+  for (uint32_t v = 0; v < HTTP_STATUS_LINE_VERSIONS; ++v) {
+    const char *version = http_version_to_string((http_version_t)v);
+    if (version == NULL)
+      version = http_version_to_string(HTTP_VERSION_1_1);
+
+    for (uint32_t c = 0; c < HTTP_STATUS_LINE_CODES; ++c) {
+      uint32_t code = c + HTTP_STATUS_LINE_MIN_CODE;
+      const char *message = http_code_get_message((http_code_t)code);
+      if (message == NULL) {
+        g_HttpStatusLines[v][c].line = NULL;
+        g_HttpStatusLines[v][c].len = 0;
+        continue;
+      }
+
+      int32_t len = sprintf(p, "%s %u %s\r\n", version, code, message);
+
+      g_HttpStatusLines[v][c].line = p;
+      g_HttpStatusLines[v][c].len = (size_t)len;
+      p += len;
+    }
+  }
+
+  return 0;
+}
+
+/// Frees the table of status lines.
+void http_status_line_free(void) {
+  memset(g_HttpStatusLines, 0, sizeof(g_HttpStatusLines));
+
+  free(g_HttpStatusLineBlock);
+  g_HttpStatusLineBlock = NULL;
+}
+
+/// Gets the formatted status line of the specified version and code, returns
+///  NULL if the code is not known.
+const http_status_line_t *http_status_line_get(http_version_t version,
+                                               uint32_t code) {
+  if ((uint32_t)version >= HTTP_STATUS_LINE_VERSIONS ||
+      code < HTTP_STATUS_LINE_MIN_CODE || code > HTTP_STATUS_LINE_MAX_CODE)
+    return NULL;
+
+  const http_status_line_t *status_line =
+      &g_HttpStatusLines[version][code - HTTP_STATUS_LINE_MIN_CODE];
+
+  return status_line->line != NULL ? status_line : NULL;
+}
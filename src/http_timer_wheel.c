@@ -0,0 +1,130 @@
+/*
+    Copyright 2021 Luke A.C.A. Rieff
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "http_timer_wheel.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// HTTP Timer Wheel
+///////////////////////////////////////////////////////////////////////////////
+
+/// Gets the current monotonic time in milliseconds.
+int64_t http_timer_wheel_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+
+  return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/// Initializes a timer wheel, the slot count must be a power of two and the
+///  tick is the resolution in milliseconds.
+int32_t http_timer_wheel_init(http_timer_wheel_t *wheel, size_t slot_count,
+                              int64_t tick) {
+  if (slot_count == 0 || (slot_count & (slot_count - 1)) != 0) {
+    fprintf(stderr, "Timer wheel slot count must be a power of two.\r\n");
+    return -1;
+  }
+
+  wheel->slots = (http_timer_t **)calloc(slot_count, sizeof(http_timer_t *));
+  if (wheel->slots == NULL)
+    return -2;
+
+  wheel->mask = slot_count - 1;
+  wheel->tick = tick;
+  wheel->current = http_timer_wheel_now() / tick;
+
+  return 0;
+}
+
+/// Frees the slots of a timer wheel, the timers themselves are not owned.
+void http_timer_wheel_free(http_timer_wheel_t *wheel) {
+  free(wheel->slots);
+  wheel->slots = NULL;
+}
+
+/// Arms (or re-arms) a timer to expire the specified milliseconds from now.
+void http_timer_wheel_arm(http_timer_wheel_t *wheel, http_timer_t *timer,
+                          int64_t timeout) {
+  http_timer_wheel_cancel(wheel, timer);
+
+  timer->deadline = http_timer_wheel_now() + timeout;
+
+  // Timers further away than one revolution simply stay in their slot until
+  //  the wheel came around often enough, the deadline tells when. The slot
+  //  is rounded up, the one before the deadline would be visited too early,
+  //  and then not again for a whole revolution.
+  int64_t expires = (timer->deadline + wheel->tick - 1) / wheel->tick;
+  if (expires <= wheel->current)
+    expires = wheel->current + 1;
+
+  timer->slot = (size_t)expires & wheel->mask;
+  http_timer_t **slot = &wheel->slots[timer->slot];
+
+  timer->prev = NULL;
+  timer->next = *slot;
+  if (*slot != NULL)
+    (*slot)->prev = timer;
+  *slot = timer;
+
+  timer->armed = true;
+}
+
+/// Cancels a timer, does nothing if it is not armed.
+void http_timer_wheel_cancel(http_timer_wheel_t *wheel, http_timer_t *timer) {
+  if (!timer->armed)
+    return;
+
+  if (timer->prev != NULL)
+    timer->prev->next = timer->next;
+  else
+    wheel->slots[timer->slot] = timer->next;
+
+  if (timer->next != NULL)
+    timer->next->prev = timer->prev;
+
+  timer->next = NULL;
+  timer->prev = NULL;
+  timer->armed = false;
+}
+
+/// Advances the wheel to the current time, and calls the callback for every
+///  timer which expired, the timer is cancelled before the call.
+void http_timer_wheel_advance(http_timer_wheel_t *wheel,
+                              http_timer_callback_t callback, void *arg) {
+  int64_t now = http_timer_wheel_now();
+  int64_t target = now / wheel->tick;
+
+  // If we were away for more than one revolution, visiting every slot once
+  //  is enough, since the deadlines are checked anyway.
+  if (target - wheel->current > (int64_t)wheel->mask + 1)
+    wheel->current = target - (int64_t)wheel->mask - 1;
+
+  while (wheel->current < target) {
+    ++wheel->current;
+
+    http_timer_t *timer = wheel->slots[(size_t)wheel->current & wheel->mask];
+    while (timer != NULL) {
+      // Gets the next one first, since the callback may free the timer.
+      http_timer_t *next = timer->next;
+
+      if (timer->deadline <= now) {
+        http_timer_wheel_cancel(wheel, timer);
+        callback(timer, arg);
+      }
+
+      timer = next;
+    }
+  }
+}
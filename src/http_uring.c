@@ -0,0 +1,298 @@
+/*
+    Copyright 2021 Luke A.C.A. Rieff
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "http_uring.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// HTTP io_uring
+///////////////////////////////////////////////////////////////////////////////
+
+/// Initializes an io_uring instance with the specified number of entries.
+int32_t http_uring_init(http_uring_t *ring, uint32_t entries) {
+  struct io_uring_params params;
+
+  memset(ring, 0, sizeof(http_uring_t));
+
+  // Creates the ring, the completion queue is made larger than the submission
+  //  queue since multishot requests post many completions per submission.
+  memset(&params, 0, sizeof(params));
+  params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_COOP_TASKRUN;
+  params.cq_entries = entries * 4;
+
+  ring->fd = (int32_t)syscall(__NR_io_uring_setup, entries, &params);
+  if (ring->fd < 0 && errno == EINVAL) {
+    // Older kernels do not support cooperative task running, retry without.
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = entries * 4;
+
+    ring->fd = (int32_t)syscall(__NR_io_uring_setup, entries, &params);
+  }
+
+  if (ring->fd < 0) {
+    perror("io_uring_setup () failed");
+    return -1;
+  }
+
+  // We rely on the single mmap, and the timeout argument of io_uring_enter,
+  //  both are available since Linux 5.11.
+  if (!(params.features & IORING_FEAT_SINGLE_MMAP) ||
+      !(params.features & IORING_FEAT_EXT_ARG)) {
+    fprintf(stderr, "io_uring lacks required features (Linux >= 5.11).\r\n");
+    close(ring->fd);
+    return -2;
+  }
+
+  // Maps the submission and completion queue rings, these share one mapping.
+  size_t sq_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+  size_t cq_size =
+      params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  ring->ring_size = sq_size > cq_size ? sq_size : cq_size;
+
+  ring->ring = mmap(NULL, ring->ring_size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+  if (ring->ring == MAP_FAILED) {
+    perror("mmap () failed");
+    close(ring->fd);
+    return -3;
+  }
+
+  // Maps the submission queue entries.
+  ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+  ring->sqes =
+      (struct io_uring_sqe *)mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+                                  MAP_SHARED | MAP_POPULATE, ring->fd,
+                                  IORING_OFF_SQES);
+  if (ring->sqes == MAP_FAILED) {
+    perror("mmap () failed");
+    munmap(ring->ring, ring->ring_size);
+    close(ring->fd);
+    return -4;
+  }
+
+  // Gets the pointers to the ring variables.
+  uint8_t *p = (uint8_t *)ring->ring;
+
+  ring->sq_head = (uint32_t *)&p[params.sq_off.head];
+  ring->sq_tail = (uint32_t *)&p[params.sq_off.tail];
+  ring->sq_mask = *(uint32_t *)&p[params.sq_off.ring_mask];
+  ring->sq_entries = params.sq_entries;
+  ring->sqe_tail = *ring->sq_tail;
+
+  ring->cq_head = (uint32_t *)&p[params.cq_off.head];
+  ring->cq_tail = (uint32_t *)&p[params.cq_off.tail];
+  ring->cq_mask = *(uint32_t *)&p[params.cq_off.ring_mask];
+  ring->cqes = (struct io_uring_cqe *)&p[params.cq_off.cqes];
+
+  // Since we always use the entries in order, the indirection array is just
+  //  filled with the identity once.
+  uint32_t *array = (uint32_t *)&p[params.sq_off.array];
+  for (uint32_t i = 0; i < params.sq_entries; ++i)
+    array[i] = i;
+
+  return 0;
+}
+
+/// Frees an io_uring instance, including the provided buffers.
+void http_uring_free(http_uring_t *ring) {
+  // Closing the ring also unregisters the buffer ring.
+  munmap(ring->sqes, ring->sqes_size);
+  munmap(ring->ring, ring->ring_size);
+
+  if (close(ring->fd) != 0)
+    perror("close () failed");
+
+  if (ring->buf_ring != NULL)
+    munmap(ring->buf_ring, ring->buf_ring_size);
+
+  free(ring->bufs);
+}
+
+/// Registers a ring of provided buffers, used by multishot receives.
+int32_t http_uring_setup_buffers(http_uring_t *ring, uint32_t count,
+                                 uint32_t size) {
+  // The buffer ring must be page aligned, so just map it.
+  ring->buf_ring_size = count * sizeof(struct io_uring_buf);
+  ring->buf_ring = (struct io_uring_buf_ring *)mmap(
+      NULL, ring->buf_ring_size, PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (ring->buf_ring == MAP_FAILED) {
+    perror("mmap () failed");
+    ring->buf_ring = NULL;
+    return -1;
+  }
+
+  // Allocates the memory for the buffers themselves.
+  ring->bufs = (uint8_t *)malloc((size_t)count * size);
+  if (ring->bufs == NULL)
+    return -2;
+
+  ring->buf_count = count;
+  ring->buf_size = size;
+
+  // Registers the buffer ring to the kernel.
+  struct io_uring_buf_reg reg;
+  memset(&reg, 0, sizeof(reg));
+  reg.ring_addr = (uint64_t)(uintptr_t)ring->buf_ring;
+  reg.ring_entries = count;
+  reg.bgid = HTTP_URING_BUFFER_GROUP;
+
+  if (syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_PBUF_RING,
+              &reg, 1) < 0) {
+    perror("io_uring_register (IORING_REGISTER_PBUF_RING) failed");
+    return -3;
+  }
+
+  // Hands all the buffers to the kernel.
+  for (uint32_t i = 0; i < count; ++i)
+    http_uring_recycle_buffer(ring, (uint16_t)i);
+
+  return 0;
+}
+
+/// Gets the provided buffer with the specified ID.
+uint8_t *http_uring_get_buffer(http_uring_t *ring, uint16_t bid) {
+  return &ring->bufs[(size_t)bid * ring->buf_size];
+}
+
+/// Gives the provided buffer back to the kernel.
+void http_uring_recycle_buffer(http_uring_t *ring, uint16_t bid) {
+  uint16_t tail = ring->buf_ring->tail;
+  struct io_uring_buf *buf = &ring->buf_ring->bufs[tail & (ring->buf_count - 1)];
+
+  buf->addr = (uint64_t)(uintptr_t)http_uring_get_buffer(ring, bid);
+  buf->len = ring->buf_size;
+  buf->bid = bid;
+
+  __atomic_store_n(&ring->buf_ring->tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+/// Submits the pending entries, and optionally waits for completions.
+int32_t __http_uring_enter(http_uring_t *ring, uint32_t wait_nr,
+                           uint32_t timeout) {
+  // Publishes the new tail, after which the kernel may see the entries.
+  __atomic_store_n(ring->sq_tail, ring->sqe_tail, __ATOMIC_RELEASE);
+
+  uint32_t to_submit =
+      ring->sqe_tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+
+  // If we're not waiting, only enter the kernel when there is something to
+  //  submit.
+  if (wait_nr == 0) {
+    if (to_submit == 0)
+      return 0;
+
+    return (int32_t)syscall(__NR_io_uring_enter, ring->fd, to_submit, 0, 0,
+                            NULL, 0);
+  }
+
+  // Builds the extended argument, which holds the timeout.
+  struct __kernel_timespec ts;
+  ts.tv_sec = timeout / 1000;
+  ts.tv_nsec = (timeout % 1000) * 1000000L;
+
+  struct io_uring_getevents_arg arg;
+  memset(&arg, 0, sizeof(arg));
+  arg.sigmask_sz = _NSIG / 8;
+  arg.ts = (uint64_t)(uintptr_t)&ts;
+
+  return (int32_t)syscall(__NR_io_uring_enter, ring->fd, to_submit, wait_nr,
+                          IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg,
+                          sizeof(arg));
+}
+
+/// Gets an empty submission queue entry, submits if the queue is full.
+struct io_uring_sqe *http_uring_get_sqe(http_uring_t *ring) {
+  // Checks if the submission queue is full, if so submit what we have so far
+  //  to make room.
+  while (ring->sqe_tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE) >=
+         ring->sq_entries) {
+    if (__http_uring_enter(ring, 0, 0) < 0 && errno != EINTR &&
+        errno != EAGAIN && errno != EBUSY) {
+      perror("io_uring_enter () failed");
+      return NULL;
+    }
+  }
+
+  struct io_uring_sqe *sqe = &ring->sqes[ring->sqe_tail & ring->sq_mask];
+  memset(sqe, 0, sizeof(struct io_uring_sqe));
+  ++ring->sqe_tail;
+
+  return sqe;
+}
+
+/// Submits all the pending submission queue entries, and waits for at least
+///  one completion or the timeout (in milliseconds) to expire.
+int32_t http_uring_submit_and_wait(http_uring_t *ring, uint32_t timeout) {
+  if (__http_uring_enter(ring, 1, timeout) < 0) {
+    if (errno == ETIME || errno == EINTR || errno == EAGAIN || errno == EBUSY)
+      return 0;
+
+    perror("io_uring_enter () failed");
+    return -1;
+  }
+
+  return 0;
+}
+
+/// Gets the next completion queue entry, or NULL if there is none.
+struct io_uring_cqe *http_uring_peek_cqe(http_uring_t *ring) {
+  uint32_t head = *ring->cq_head;
+  if (head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE))
+    return NULL;
+
+  return &ring->cqes[head & ring->cq_mask];
+}
+
+/// Marks the current completion queue entry as seen.
+void http_uring_cqe_seen(http_uring_t *ring) {
+  __atomic_store_n(ring->cq_head, *ring->cq_head + 1, __ATOMIC_RELEASE);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// HTTP io_uring Preparation
+///////////////////////////////////////////////////////////////////////////////
+
+/// Prepares a multishot receive, which uses the provided buffers.
+void http_uring_prep_recv_multishot(struct io_uring_sqe *sqe, int32_t fd,
+                                    uint64_t user_data) {
+  sqe->opcode = IORING_OP_RECV;
+  sqe->fd = fd;
+  sqe->ioprio = IORING_RECV_MULTISHOT;
+  sqe->flags = IOSQE_BUFFER_SELECT;
+  sqe->buf_group = HTTP_URING_BUFFER_GROUP;
+  sqe->user_data = user_data;
+}
+
+/// Prepares a (possibly multishot) poll.
+void http_uring_prep_poll(struct io_uring_sqe *sqe, int32_t fd,
+                          uint32_t events, bool multishot,
+                          uint64_t user_data) {
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = fd;
+  sqe->poll32_events = events;
+  sqe->len = multishot ? IORING_POLL_ADD_MULTI : 0;
+  sqe->user_data = user_data;
+}
+
+/// Prepares the cancellation of the request with the target user data.
+void http_uring_prep_cancel(struct io_uring_sqe *sqe, uint64_t target,
+                            uint64_t user_data) {
+  sqe->opcode = IORING_OP_ASYNC_CANCEL;
+  sqe->fd = -1;
+  sqe->addr = target;
+  sqe->user_data = user_data;
+}
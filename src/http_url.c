@@ -16,47 +16,24 @@
 
 #include "http_url.h"
 
-/// Parses an URL.
-int32_t http_url_parse (http_url_t *url, const char *raw) {
-    size_t len = strlen (raw);
-
-    // Checks if we're dealing with search parameters, if so read them from the
-    //  url and store them in the reuslt URL.
-    char *p = strrchr (raw, '?');
+/// Splits the target of a request into its path and query, which are slices
+///  of the same buffer. The query does not include the question mark, and is
+///  empty when there are no search parameters.
+int32_t http_url_parse (http_url_t *url, const uint8_t *buffer, http_slice_t target) {
+    const uint8_t *p = memchr (&buffer[target.offset], '?', target.len);
+
+    // Everything up to the first question mark is the path, and everything
+    //  after it the query, nothing is copied.
+    url->path.offset = target.offset;
     if (p != NULL) {
-        // Gets the length of the remaining part of the string, after which we allocate
-        //  the required amount to store search in.
-        size_t search_size = strlen (p);
-        if ((url->search = malloc (search_size + 1)) == NULL)
-            return -1;
-
-        // Copies the search part of the string to the new url->search thingy.
-        memcpy (url->search, p, search_size);
-        url->search[search_size] = '\0';
-
-        // Removes the search length from the final length to copy,
-        //  this will leave us with the path only.
-        len -= search_size;
+        url->path.len = (uint32_t) (p - &buffer[target.offset]);
+        url->query.offset = target.offset + url->path.len + 1;
+        url->query.len = target.len - url->path.len - 1;
+    } else {
+        url->path.len = target.len;
+        url->query.offset = target.offset + target.len;
+        url->query.len = 0;
     }
 
-    // Allocates the memory to store the path in.
-    if ((url->path = malloc (len + 1)) == NULL) {
-        if (url->search != NULL)
-            free (url->search);
-        return -1;
-    }
-    
-    // Copies the path into the newly allocated memory.
-    memcpy (url->path, raw, len);
-    url->path[len] = '\0';
-    
     return 0;
 }
-
-/// Frees an URL.
-void http_url_free (http_url_t *url) {
-    if (url->path != NULL)
-        free (url->path);
-    if (url->search != NULL)
-        free (url->search);
-}
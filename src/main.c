@@ -22,6 +22,62 @@
 
 http_router_t router = {.entry = NULL};
 
+struct argp_option g_Options[] = {
+    {"engine", 'e', "ENGINE", 0, "Socket pool engine: epoll (default) or io_uring."},
+    {"pool-listeners", 'l', NULL, 0, "Let every pool accept on its own SO_REUSEPORT listener."},
+    {"placement", 'p', "POLICY", 0, "Connection placement: round-robin (default), least-connections, power-of-two or address-hash."},
+    {"pools", 'n', "COUNT", 0, "Number of socket pools, defaults to one per allowed CPU."},
+    {"pin", 'c', NULL, 0, "Pin every socket pool to its own CPU."},
+    {"zerocopy", 'z', NULL, 0, "Send large owned byte bodies with MSG_ZEROCOPY."},
+    {0}};
+
+/// Parses a single command line option.
+error_t __main_parse_opt(int key, char *arg, struct argp_state *state) {
+  main_args_t *args = (main_args_t *)state->input;
+
+  switch (key) {
+  case 'e':
+    if (strcmp(arg, "epoll") == 0)
+      args->engine = HTTP_SERVER_SOCKET_POOL_ENGINE_EPOLL;
+    else if (strcmp(arg, "io_uring") == 0)
+      args->engine = HTTP_SERVER_SOCKET_POOL_ENGINE_IO_URING;
+    else
+      argp_error(state, "invalid engine '%s'", arg);
+    break;
+  case 'l':
+    args->pool_listeners = true;
+    break;
+  case 'p':
+    if (strcmp(arg, "round-robin") == 0)
+      args->placement = HTTP_SERVER_SOCKET_PLACEMENT_ROUND_ROBIN;
+    else if (strcmp(arg, "least-connections") == 0)
+      args->placement = HTTP_SERVER_SOCKET_PLACEMENT_LEAST_CONNECTIONS;
+    else if (strcmp(arg, "power-of-two") == 0)
+      args->placement = HTTP_SERVER_SOCKET_PLACEMENT_POWER_OF_TWO;
+    else if (strcmp(arg, "address-hash") == 0)
+      args->placement = HTTP_SERVER_SOCKET_PLACEMENT_ADDRESS_HASH;
+    else
+      argp_error(state, "invalid placement '%s'", arg);
+    break;
+  case 'n':
+    args->pool_count = strtoul(arg, NULL, 10);
+    break;
+  case 'c':
+    args->pin_pools = true;
+    break;
+  case 'z':
+    args->zerocopy = true;
+    break;
+  default:
+    return ARGP_ERR_UNKNOWN;
+  }
+
+  return 0;
+}
+
+struct argp g_Argp = {g_Options, __main_parse_opt, NULL,
+                      "Lu-HTTP, a small multi-threaded HTTP server."};
+
 void print_header(const char *memory, void *u) { printf("%s", memory); }
 
 void *recurring_thread(void *u) {
@@ -33,9 +89,11 @@ void *recurring_thread(void *u) {
 
 void on_http_request(http_socket_t *socket, const http_request_t *request,
                      http_response_t *response) {
-  printf("%s\n", request->parsed_url.path);
+  printf("%.*s\n", (int)http_request_get_path_len(request),
+         http_request_get_path(request));
   int32_t rc = http_router_use(&router, socket, request, response,
-                               request->parsed_url.path);
+                               http_request_get_path(request),
+                               http_request_get_path_len(request));
 
   if (rc == 1) {
     http_response_set_code(response, 404);
@@ -44,12 +102,20 @@ void on_http_request(http_socket_t *socket, const http_request_t *request,
 }
 
 void static_route(http_socket_t *socket, const http_request_t *request,
-                  http_response_t *response, const char *path, void *u) {
-  char *file_path = malloc(strlen(path) + strlen((const char *)u) + 2);
-  sprintf(file_path, "%s/%s", (const char *)u, path);
+                  http_response_t *response, const char *path, size_t path_len,
+                  void *u) {
+  // Builds the path on the stack, it's the key of the file cache, paths
+  //  which leave the static directory are never served.
+  char file_path[PATH_MAX];
+  int32_t len =
+      snprintf(file_path, sizeof(file_path), "%s/%.*s", (const char *)u,
+               (int)path_len, path != NULL ? path : "");
 
   http_response_set_code(response, 200);
-  int32_t rc = http_response_write_file(socket, response, file_path);
+  int32_t rc = -1;
+  if (path != NULL && memmem(path, path_len, "..", 2) == NULL && len > 0 &&
+      (size_t)len < sizeof(file_path))
+    rc = http_response_write_file(socket, response, file_path);
   if (rc == -1) {
     http_response_set_code(response, 404);
     http_response_write_file(socket, response, "./html/404.html");
@@ -57,7 +123,8 @@ void static_route(http_socket_t *socket, const http_request_t *request,
 }
 
 void test_route(http_socket_t *socket, const http_request_t *request,
-                http_response_t *response, const char *path, void *u) {
+                http_response_t *response, const char *path, size_t path_len,
+                void *u) {
   http_response_set_code(response, 200);
   http_response_write_text(socket, response, HTTP_CONTENT_TYPE_TEXT_PLAIN,
                            "test!");
@@ -65,6 +132,7 @@ void test_route(http_socket_t *socket, const http_request_t *request,
 
 void __main_register_routes() {
   http_router__register_callback(&router, "static", static_route, "./static");
+  http_route_flag_set(router.entry, HTTP_ROUTE_FLAG__MATCH_ALL);
   http_router__register_callback(&router, "test", test_route, NULL);
 }
 
@@ -73,6 +141,13 @@ int main(int argc, char **argv) {
   srand(time(NULL));
 
   // Handles the arguments.
+  main_args_t args = {.engine = HTTP_SERVER_SOCKET_POOL_ENGINE_EPOLL,
+                      .pool_listeners = false,
+                      .placement = HTTP_SERVER_SOCKET_PLACEMENT_ROUND_ROBIN,
+                      .pool_count = 0,
+                      .pin_pools = false,
+                      .zerocopy = false};
+  argp_parse(&g_Argp, argc, argv, 0, NULL, &args);
 
   // Prints some deserved credits.
   printf(
@@ -87,10 +162,24 @@ int main(int argc, char **argv) {
   __main_register_routes();
 
   http_response_prepare_default_headers();
+  http_status_line_init();
+  http_response_prepare_caches();
   http_helpers_init();
 
   http_server_socket_t *sock =
-      http_server_socket_create(10, 1024, on_http_request);
+      http_server_socket_create(args.pool_count, 1024, args.engine,
+                                on_http_request);
+
+  if (args.pool_listeners)
+    http_server_socket_flag_set(sock, HTTP_SERVER_SOCKET_FLAG_POOL_LISTENERS);
+
+  if (args.pin_pools)
+    http_server_socket_flag_set(sock, HTTP_SERVER_SOCKET_FLAG_PIN_POOLS);
+
+  if (args.zerocopy)
+    http_server_socket_flag_set(sock, HTTP_SERVER_SOCKET_FLAG_ZEROCOPY);
+
+  sock->placement = args.placement;
 
   http_server_socket_init(sock);
   http_server_socket_configure(sock, 8080, "0.0.0.0", 20);
@@ -109,5 +198,7 @@ int main(int argc, char **argv) {
   http_server_socket_free(&sock);
 
   http_response_free_default_headers();
+  http_status_line_free();
+  http_response_free_caches();
   return 0;
 }
@@ -26,6 +26,7 @@ int32_t http_router__register_callback(http_router_t *router, const char *path,
 
   // Sets the values inside the route.
   route->path = path;
+  route->path_len = strlen(path);
   route->type = HTTP_ROUTE_TYPE__CALLBACK;
   route->data = (void *)callback;
   route->u = u;
@@ -55,6 +56,7 @@ http_router_t *http_router__register_subroute(http_router_t *router,
 
   // Sets the route values.
   route->path = path;
+  route->path_len = strlen(path);
   route->type = HTTP_ROUTE_TYPE__SUBROUTER;
   route->data = (void *)sub_router;
 
@@ -66,30 +68,48 @@ http_router_t *http_router__register_subroute(http_router_t *router,
   return sub_router;
 }
 
-/// Uses an HTTP router.
-int32_t http_router_use(http_router_t *router, http_socket_t *socket,
-                        const http_request_t *request,
-                        http_response_t *response, const char *path) {
-  // Allocates the memory for the strtok_r function, if this fails return error
-  //  else copy the path into the strtok path.
-  char *strtok_mem = malloc(strlen(path) + 1);
-  if (strtok_mem == NULL) {
-    return -1;
+/// Gets the next part of the path, which starts at offset, the slashes
+///  before it are skipped. Returns NULL if there are no parts left.
+const char *__http_router_next_part(const char *path, size_t path_len,
+                                    size_t *offset, size_t *part_len) {
+  size_t i = *offset;
+  while (i < path_len && path[i] == '/')
+    ++i;
+
+  if (i == path_len) {
+    *offset = i;
+    return NULL;
   }
 
-  memcpy(strtok_mem, path, strlen(path) + 1);
+  size_t start = i;
+  while (i < path_len && path[i] != '/')
+    ++i;
+
+  *part_len = i - start;
+  *offset = i;
+
+  return &path[start];
+}
 
+/// Uses an HTTP router, the path does not have to be terminated, the parts
+///  of it are matched in place.
+int32_t http_router_use(http_router_t *router, http_socket_t *socket,
+                        const http_request_t *request,
+                        http_response_t *response, const char *path,
+                        size_t path_len) {
   // Loops over all the parts of the url, and starts matching the routes we
   // have.
-  char *save_ptr;
-  char *token = strtok_r(strtok_mem, "/", &save_ptr);
+  size_t offset = 0, token_len = 0;
+  const char *token =
+      __http_router_next_part(path, path_len, &offset, &token_len);
 
   while (token != NULL) {
     // Checks for any matching routes.
     http_route_t *route = router->entry;
     while (route != NULL) {
       // Checks if we're matching, if not continue to next round.
-      if (strcmp(token, route->path) != 0) {
+      if (route->path_len != token_len ||
+          memcmp(token, route->path, token_len) != 0) {
         route = route->next;
         continue;
       }
@@ -97,39 +117,37 @@ int32_t http_router_use(http_router_t *router, http_socket_t *socket,
       // Checks the type of match, if callback just call the function
       //  else search the sub-router.
       if (route->type == HTTP_ROUTE_TYPE__CALLBACK) {
-        token = strtok_r(NULL, "/", &save_ptr);
+        // Gets the remaining path, if any at all.
+        size_t remaining_offset = offset, remaining_len = 0;
+        const char *remaining_path = __http_router_next_part(
+            path, path_len, &remaining_offset, &remaining_len);
+        if (remaining_path != NULL)
+          remaining_len = &path[path_len] - remaining_path;
 
         // Checks if there is a remaining path, if so, if the route is match all
         //  otherwise ignore the route.
-        if (!http_route_flag_is_set(route, HTTP_ROUTE_FLAG__MATCH_ALL) && token != NULL) {
+        if (!http_route_flag_is_set(route, HTTP_ROUTE_FLAG__MATCH_ALL) &&
+            remaining_path != NULL) {
           route = route->next;
           continue;
         }
 
-        // Gets the remaining path, if any at all.
-        const char *remaining_path = NULL;
-        if (token != NULL) {
-          size_t i = token - strtok_mem;
-          remaining_path = &path[i];
-        }
-
         // Calls the callback.
         ((http_route_callback)(route->data))(socket, request, response,
-                                             remaining_path, route->u);
+                                             remaining_path, remaining_len,
+                                             route->u);
       } else if (route->type == HTTP_ROUTE_TYPE__SUBROUTER) {
         router = (http_router_t *)route->data;
         break;
       }
 
-      free(strtok_mem);
       return 0;
     }
 
-    token = strtok_r(NULL, "/", &save_ptr);
+    token = __http_router_next_part(path, path_len, &offset, &token_len);
   }
 
-  // Frees the memory, and returns 1 since we've not found any matching route
-  //  and thus need to render 404.
-  free(strtok_mem);
+  // Returns 1 since we've not found any matching route and thus need to
+  //  render 404.
   return 1;
 }
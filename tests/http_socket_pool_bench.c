@@ -0,0 +1,193 @@
+/*
+    Copyright 2021 Luke A.C.A. Rieff
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <stdio.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <time.h>
+
+#include "http_socket.h"
+
+/// The number of operations timed per connection count, the list walk is
+///  timed with fewer lookups, since it gets slow for the larger counts.
+#define BENCH_LOOKUPS (1000 * 1000)
+#define BENCH_WALKS (10 * 1000)
+#define BENCH_CHURNS (10 * 1000)
+#define BENCH_ROUNDS 1000
+
+/// The number of sockets which become ready per event loop round.
+#define BENCH_READY 64
+
+/// Gets the monotonic time in nanoseconds.
+int64_t __bench_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/// Picks the next pseudo-random socket, with xorshift.
+size_t __bench_next(uint32_t *state, size_t count) {
+  uint32_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+
+  return x % count;
+}
+
+/// Creates an eventfd backed socket, and registers it to the pool.
+http_socket_t *__bench_add_socket(http_server_socket_pool_t *pool) {
+  http_socket_t *socket = __http_socket_pool__alloc_socket(pool);
+  if (socket == NULL)
+    return NULL;
+
+  socket->fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (socket->fd < 0 || __http_socket_pool_register_socket(pool, socket) != 0) {
+    perror("registering socket failed");
+    return NULL;
+  }
+
+  return socket;
+}
+
+/// Walks the socket list of the pool, which is how a socket was looked up
+///  before the fd-indexed table.
+http_socket_t *__bench_walk(http_server_socket_pool_t *pool, int32_t fd) {
+  for (http_socket_t *socket = pool->start; socket != NULL;
+       socket = socket->next)
+    if (socket->fd == fd)
+      return socket;
+
+  return NULL;
+}
+
+/// Times the socket operations of a pool with the specified number of
+///  connections, and prints the cost per operation.
+int32_t __bench_run(size_t count) {
+  http_server_socket_pool_t *pool =
+      __http_server_socket_pool_create(count, HTTP_SERVER_SOCKET_POOL_ENGINE_EPOLL);
+  if (pool == NULL)
+    return -1;
+
+  int32_t *fds = (int32_t *)malloc(count * sizeof(int32_t));
+  if (fds == NULL)
+    return -1;
+
+  for (size_t i = 0; i < count; ++i) {
+    http_socket_t *socket = __bench_add_socket(pool);
+    if (socket == NULL)
+      return -1;
+
+    fds[i] = socket->fd;
+  }
+
+  uint32_t state = 2463534242u;
+  size_t found = 0;
+
+  // Looks up random sockets through the fd-indexed table.
+  int64_t start = __bench_now();
+  for (size_t i = 0; i < BENCH_LOOKUPS; ++i)
+    found += __http_socket_pool__get_socket_by_fd(
+                 pool, fds[__bench_next(&state, count)]) != NULL;
+  double lookup = (double)(__bench_now() - start) / BENCH_LOOKUPS;
+
+  // Looks up random sockets by walking the list, for comparison.
+  start = __bench_now();
+  for (size_t i = 0; i < BENCH_WALKS; ++i)
+    found += __bench_walk(pool, fds[__bench_next(&state, count)]) != NULL;
+  double walk = (double)(__bench_now() - start) / BENCH_WALKS;
+
+  // Closes random connections and accepts new ones in their place, the new
+  //  eventfd gets the fd which has just been closed.
+  start = __bench_now();
+  for (size_t i = 0; i < BENCH_CHURNS; ++i) {
+    size_t index = __bench_next(&state, count);
+    __http_socket_pool__close_socket(
+        pool, __http_socket_pool__get_socket_by_fd(pool, fds[index]));
+
+    http_socket_t *socket = __bench_add_socket(pool);
+    if (socket == NULL)
+      return -1;
+
+    fds[index] = socket->fd;
+  }
+  double churn = (double)(__bench_now() - start) / BENCH_CHURNS;
+
+  // Makes random sockets ready, and dispatches their events like the event
+  //  loop does, this includes the epoll_wait and the eventfd system calls.
+  size_t events = 0;
+  start = __bench_now();
+  for (size_t i = 0; i < BENCH_ROUNDS; ++i) {
+    for (size_t j = 0; j < BENCH_READY; ++j)
+      eventfd_write(fds[__bench_next(&state, count)], 1);
+
+    int32_t n_events = epoll_wait(pool->epoll_fd, pool->events,
+                                  HTTP_SERVER_SOCKET_POOL_MAX_EVENTS, 0);
+    for (int32_t j = 0; j < n_events; ++j) {
+      http_socket_t *socket =
+          __http_socket_pool__get_socket_by_fd(pool, pool->events[j].data.fd);
+      if (socket == NULL)
+        continue;
+
+      eventfd_t value;
+      eventfd_read(socket->fd, &value);
+      ++events;
+    }
+  }
+  double dispatch = (double)(__bench_now() - start) / (double)events;
+
+  printf("%10zu %12.1f %12.1f %12.1f %12.1f\n", count, lookup, walk, churn,
+         dispatch);
+
+  // Closes all the connections, and frees the pool.
+  while (pool->start != NULL)
+    __http_socket_pool__close_socket(pool, pool->start);
+
+  free(fds);
+  __http_server_socket_pool_free(&pool);
+
+  return found == BENCH_LOOKUPS + BENCH_WALKS ? 0 : -1;
+}
+
+int main(void) {
+  const size_t counts[] = {100, 1000, 10000, 50000};
+
+  // Every connection is an eventfd, so the counts are capped by the limit
+  //  of open files, raise it as far as we're allowed to.
+  struct rlimit limit;
+  getrlimit(RLIMIT_NOFILE, &limit);
+  limit.rlim_cur = limit.rlim_max;
+  setrlimit(RLIMIT_NOFILE, &limit);
+
+  printf("%10s %12s %12s %12s %12s\n", "sockets", "lookup (ns)", "walk (ns)",
+         "churn (ns)", "event (ns)");
+
+  for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); ++i) {
+    if (counts[i] + 16 > limit.rlim_cur) {
+      printf("%10zu skipped, the limit of open files is %lu\n", counts[i],
+             (unsigned long)limit.rlim_cur);
+      continue;
+    }
+
+    if (__bench_run(counts[i]) != 0) {
+      fprintf(stderr, "FAIL: benchmark with %zu sockets failed\n", counts[i]);
+      return 1;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,65 @@
+/*
+    Copyright 2021 Luke A.C.A. Rieff
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include "http_timer_wheel.h"
+
+/// The tick and timeout of the test, the timer has to fire within one tick
+///  of its deadline, plus the resolution of the coarse clock.
+#define TEST_TICK 50
+#define TEST_TIMEOUT 1000
+#define TEST_SLACK 10
+
+int64_t g_FiredAt = -1;
+
+/// Remembers when the timer fired.
+void __test_on_expired(http_timer_t *timer, void *arg) {
+  g_FiredAt = http_timer_wheel_now();
+}
+
+int main(void) {
+  http_timer_wheel_t wheel;
+  if (http_timer_wheel_init(&wheel, 512, TEST_TICK) != 0)
+    return 1;
+
+  http_timer_t timer = {0};
+  http_timer_wheel_arm(&wheel, &timer, TEST_TIMEOUT);
+
+  // Advances in steps much smaller than the tick, like a busy event loop.
+  int64_t give_up = timer.deadline + 5 * TEST_TIMEOUT;
+  while (g_FiredAt < 0 && http_timer_wheel_now() < give_up) {
+    usleep(2 * 1000);
+    http_timer_wheel_advance(&wheel, __test_on_expired, NULL);
+  }
+
+  http_timer_wheel_free(&wheel);
+
+  if (g_FiredAt < 0) {
+    fprintf(stderr, "FAIL: timer did not fire\n");
+    return 1;
+  } else if (g_FiredAt < timer.deadline ||
+             g_FiredAt > timer.deadline + TEST_TICK + TEST_SLACK) {
+    fprintf(stderr, "FAIL: timer fired %ld ms after its deadline\n",
+            (long)(g_FiredAt - timer.deadline));
+    return 1;
+  }
+
+  printf("PASS: timer fired %ld ms after its deadline\n",
+         (long)(g_FiredAt - timer.deadline));
+  return 0;
+}